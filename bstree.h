@@ -8,14 +8,40 @@ Copyright © wkangk <wangkangchn@163.com>
             见 bstree_demo.c
 时间	   	: 2020-09-22 11:03
 ***************************************************************/
+#ifndef __BSTREE_H__
+#define __BSTREE_H__
 #include <stdbool.h>
+#include <pthread.h>
 #include "tools.h"
 #include "list.h"
 
 typedef int (*__compare_fn)(const void *, const void *);
 
+/**
+ * 定义树结构体以及游标结构体 tree_name_cursor
+ * @__compare:  函数指针, 比较节点键值的大小
+ * @pool:       节点对象池, 为 NULL 时节点使用 calloc 分配
+ * @rwlock:     读写锁, 多线程共享时使用 xxx_rwlock 操作
+ * @stack:      游标中尚未访问的祖先节点, 栈顶为游标当前所在节点
+ */
+#define __DEFINE_BSTREE_TREE(node_name, tree_name)  \
+    typedef struct tree_name {          \
+        node_name *root;                \
+        __compare_fn __compare;         \
+        obj_pool *pool;                 \
+        pthread_rwlock_t rwlock;        \
+    } tree_name;                        \
+    typedef struct tree_name ## _cursor {   \
+        node_name **stack;              \
+        int depth;                      \
+        int capacity;                   \
+    } tree_name ## _cursor
+
 /**
  * 定义节点数据域以及结构体名字
+ *      Note:
+ *          键值直接存放在节点内, 与左右孩子指针处于同一缓存行, 每次插入只分配一次;
+ *          键值较大时可将 type 定义为指针类型
  * @type:	    数据域类型
  * @node_name:	节点结构体名字
  * @tree_name:	树构体名字
@@ -24,12 +50,9 @@ typedef int (*__compare_fn)(const void *, const void *);
     typedef struct node_name {          \
         struct node_name *left;         \
         struct node_name *right;        \
-        type *data;                     \
+        type data;                      \
     } node_name;                        \
-    typedef struct tree_name {          \
-        node_name *root;                \
-        __compare_fn __compare;         \
-    } tree_name
+    __DEFINE_BSTREE_TREE(node_name, tree_name)
 
 
 enum TraversalType     
@@ -41,16 +64,44 @@ enum TraversalType
 
 /**
  * calloc_node - 分配节点空间, 插入键值
- * @val:	待插入键值
+ * @val:	待插入键值的地址
  * @return: 新分配的节点指针
  */
 #define calloc_node(val, type)    ({              \
     type *__node =  calloc_buf(1, type);    \
-    __node->data = calloc_buf(1, typeof( *__node->data ) ); \
-    *__node->data = *(val);                      \
+    __node->data = *(val);                  \
     __node;                                 \
 })
 
+/**
+ * alloc_node - 为树分配节点, 树配置了对象池时从池中分配
+ * @tree:   树结构体的地址
+ * @val:	待插入键值的地址
+ * @return: 新分配的节点指针
+ */
+#define alloc_node(tree, val)   ({  \
+    typeof( (tree)->root ) __anode; \
+    if ( (tree)->pool ) {           \
+        __anode = pool_alloc( (tree)->pool, typeof( *__anode ) );  \
+        __anode->data = *(val);     \
+    } else                          \
+        __anode = calloc_node( (val), typeof( *__anode ) );        \
+    __anode;                        \
+})
+
+/**
+ * free_node - 释放树节点, 并将节点指针置空
+ * @tree:   树结构体的地址
+ * @node:	待释放的节点
+ */
+#define free_node(tree, node)   ({  \
+    if ( (tree)->pool ) {           \
+        pool_free( (tree)->pool, (node) );  \
+        (node) = NULL;              \
+    } else                          \
+        free_buf( (node) );         \
+})
+
 /**
  * insert - 向二叉搜索树插入键值
  * @tree:   树(二级指针, 数指针的地址)
@@ -58,9 +109,9 @@ enum TraversalType
  */
 #define insert(tree, val)   ({  \
     typeof( (tree)->root ) *node = &( (tree)->root ); \
-    typeof( (tree)->root ) __temp = calloc_node( (val), typeof( *((tree)->root) ) );   \
+    typeof( (tree)->root ) __temp = alloc_node( (tree), (val) );   \
     while (*node != NULL)           \
-        if ( (tree)->__compare( __temp->data, (*node)->data ) <= 0 ) node = &(*node)->left; \
+        if ( (tree)->__compare( &__temp->data, &(*node)->data ) <= 0 ) node = &(*node)->left; \
         else node = &(*node)->right;                    \
     (*node) = __temp;                         \
 })
@@ -73,11 +124,13 @@ enum TraversalType
  */
 #define find(tree, val)     ({          \
     bool __result = false;              \
+    int __cmp;                          \
     typeof( (tree)->root ) __node = (tree)->root; \
     while (true)    {                   \
         if (__node == NULL)     break;  \
-        if      ( (tree)->__compare( (val), __node->data ) < 0 )     __node = __node->left;  \
-        else if ( (tree)->__compare( (val), __node->data ) > 0 )     __node = __node->right; \
+        __cmp = (tree)->__compare( (val), &__node->data ); \
+        if      (__cmp < 0)     __node = __node->left;  \
+        else if (__cmp > 0)     __node = __node->right; \
         else {  __result = true;    break;  }               \
     }           \
     __result;   \
@@ -85,13 +138,14 @@ enum TraversalType
 
 /**
  * find_rightmost_key - 查找最右子树键值, 返回其上的键值, 而后删除该节点
- * @tree:   待搜索的子树	
+ * @tree:   树结构体的地址
+ * @slot:   待搜索的子树(子树指针的地址)
  * @return: 最右子树的键值
  */
-#define find_rightmost_key(tree)    ({  \
-    typeof( (tree) ) __node_ = tree; \
-    typeof( *(tree) ) __temp;       \
-    typeof( (*(tree))->data ) __key;  \
+#define find_rightmost_key(tree, slot)    ({  \
+    typeof( (slot) ) __node_ = (slot); \
+    typeof( *(slot) ) __temp;       \
+    typeof( (*(slot))->data ) __key;  \
 \
     while (true)    {   \
         if ((*__node_)->right) __node_ = &(*__node_)->right;   \
@@ -100,11 +154,11 @@ enum TraversalType
             __key = __temp->data;\
             if (__temp->left)   *__node_ = __temp->left;  \
             else                *__node_ = NULL;         \
-            free_buf(__temp);   \
+            free_node( (tree), __temp ); \
             break;              \
         }   \
     }   \
-    *__key;  \
+    __key;  \
 })
 
 /**
@@ -119,17 +173,990 @@ enum TraversalType
     typeof( (tree)->root ) *__node = &( (tree)->root ); \
     typeof( *__node )   __temp;         \
     while ((*__node) != NULL)  {           \
-        if      ( (tree)->__compare( (val), (*__node)->data ) < 0 )     (__node) = &(*__node)->left;  \
-        else if ( (tree)->__compare( (val), (*__node)->data ) > 0 )     (__node) = &(*__node)->right; \
+        if      ( (tree)->__compare( (val), &(*__node)->data ) < 0 )     (__node) = &(*__node)->left;  \
+        else if ( (tree)->__compare( (val), &(*__node)->data ) > 0 )     (__node) = &(*__node)->right; \
         else {  \
-            if ((*__node)->left && (*__node)->right)            *(*__node)->data = find_rightmost_key(&(*__node)->left);  \
-            else if (!((*__node)->left || (*__node)->right))    free_buf(*__node);                                      \
+            if ((*__node)->left && (*__node)->right)            (*__node)->data = find_rightmost_key( (tree), &(*__node)->left );  \
+            else if (!((*__node)->left || (*__node)->right))    free_node( (tree), *__node );                           \
             else {  \
                 __temp = *__node;   \
                 if ((*__node)->left)    (*__node) = (*__node)->left;        \
                 else                    (*__node) = (*__node)->right;       \
-                free_buf(__temp);   \
+                free_node( (tree), __temp );   \
             }   \
         }   \
     }   \
 })
+
+
+/* ==============================================================================
+ *                          非递归遍历与清空
+ *
+ * 使用 Morris 遍历: 借用左子树最右节点空闲的 right 指针指回当前节点作为返回路径,
+ * 不需要递归和栈, 额外空间 O(1), 退化为链表的树也不会栈溢出. 遍历结束后树恢复原状.
+ *      Note:
+ *          1. op 直接展开调用(函数名或宏均可), 调用形式为 op(node), 没有逐节点的函数指针开销
+ *          2. 遍历期间树被临时修改, op 中只能访问 node->data, 不能访问左右孩子,
+ *          不能修改树的结构, 也不能与其他线程的读操作并发
+ * 普通二叉搜索树与 AVL 树通用.
+ * ============================================================================== */
+
+/**
+ * __bstree_thread - 查找 node 左子树的最右节点(node 的中序前驱)
+ * @node:   左子树非空的节点
+ * @return: 前驱节点, 其 right 为 NULL(未建立线索) 或 node(已建立线索)
+ */
+#define __bstree_thread(node)   ({  \
+    typeof( node ) __pre = (node)->left;    \
+    while (__pre->right && __pre->right != (node))  \
+        __pre = __pre->right;       \
+    __pre;                          \
+})
+
+/**
+ * bstree_preorder - 先根遍历
+ * @tree:   树结构体的地址
+ * @op:     对每个节点执行的操作
+ */
+#define bstree_preorder(tree, op)   ({  \
+    typeof( (tree)->root ) __cur = (tree)->root, __pre;   \
+    while (__cur) {                     \
+        if (__cur->left == NULL) {      \
+            op(__cur);                  \
+            __cur = __cur->right;       \
+        } else if ((__pre = __bstree_thread(__cur))->right == NULL) {  \
+            op(__cur);                  \
+            __pre->right = __cur;       \
+            __cur = __cur->left;        \
+        } else {                        \
+            __pre->right = NULL;        \
+            __cur = __cur->right;       \
+        }                               \
+    }                                   \
+})
+
+/**
+ * bstree_inorder - 中根遍历, 按键值从小到大访问
+ * @tree:   树结构体的地址
+ * @op:     对每个节点执行的操作
+ */
+#define bstree_inorder(tree, op)    ({  \
+    typeof( (tree)->root ) __cur = (tree)->root, __pre;   \
+    while (__cur) {                     \
+        if (__cur->left == NULL) {      \
+            op(__cur);                  \
+            __cur = __cur->right;       \
+        } else if ((__pre = __bstree_thread(__cur))->right == NULL) {  \
+            __pre->right = __cur;       \
+            __cur = __cur->left;        \
+        } else {                        \
+            __pre->right = NULL;        \
+            op(__cur);                  \
+            __cur = __cur->right;       \
+        }                               \
+    }                                   \
+})
+
+/**
+ * __bstree_reverse - 反转 from 到 to 之间沿 right 指针的路径
+ */
+#define __bstree_reverse(from, to)  ({  \
+    typeof( from ) __x = (from), __y, __z;  \
+    if (__x != (to)) {                  \
+        __y = __x->right;               \
+        do {                            \
+            __z = __y->right;           \
+            __y->right = __x;           \
+            __x = __y;                  \
+            __y = __z;                  \
+        } while (__x != (to));          \
+    }                                   \
+})
+
+/**
+ * __bstree_visit_reverse - 逆序访问 from 到 to 之间沿 right 指针的路径, 完成后恢复路径
+ */
+#define __bstree_visit_reverse(from, to, op)    ({  \
+    typeof( from ) __vfrom = (from), __vto = (to), __p;    \
+    __bstree_reverse(__vfrom, __vto);   \
+    for (__p = __vto; ; __p = __p->right) { \
+        op(__p);                        \
+        if (__p == __vfrom)     break;  \
+    }                                   \
+    __bstree_reverse(__vto, __vfrom);   \
+})
+
+/**
+ * bstree_postorder - 后根遍历
+ *      Note:
+ *          以一个左孩子为根的哑节点开始 Morris 遍历, 返回到某节点时逆序访问其左子树的最右路径
+ * @tree:   树结构体的地址
+ * @op:     对每个节点执行的操作, 不能在 op 中释放节点(清空树使用 bstree_clear)
+ */
+#define bstree_postorder(tree, op)  ({  \
+    typeof( *(tree)->root ) __dummy;    \
+    typeof( (tree)->root ) __cur = &__dummy, __pre; \
+    __dummy.left = (tree)->root;        \
+    __dummy.right = NULL;               \
+    while (__cur) {                     \
+        if (__cur->left == NULL) {      \
+            __cur = __cur->right;       \
+        } else if ((__pre = __bstree_thread(__cur))->right == NULL) {  \
+            __pre->right = __cur;       \
+            __cur = __cur->left;        \
+        } else {                        \
+            __bstree_visit_reverse(__cur->left, __pre, op); \
+            __pre->right = NULL;        \
+            __cur = __cur->right;       \
+        }                               \
+    }                                   \
+})
+
+/**
+ * bstree_traversal - 按 type 指定的顺序遍历树
+ * @tree:   树结构体的地址
+ * @type:   遍历类型(enum TraversalType)
+ * @op:     对每个节点执行的操作
+ */
+#define bstree_traversal(tree, type, op)    ({  \
+    switch (type) {                     \
+    case PRE_ORDER:     bstree_preorder( (tree), op );   break;  \
+    case IN_ORDER:      bstree_inorder( (tree), op );    break;  \
+    case POST_ORDER:    bstree_postorder( (tree), op );  break;  \
+    }                                   \
+})
+
+/**
+ * bstree_clear - 释放树的全部节点
+ *      Note:
+ *          根有左孩子时右旋, 把左子树逐步转到右侧, 根没有左孩子时释放根并转向右子树,
+ *          每个节点最多旋转一次, 时间 O(n), 额外空间 O(1)
+ * @tree:   树结构体的地址
+ * @return: 无
+ */
+#define bstree_clear(tree)  ({  \
+    typeof( (tree)->root ) __cur = (tree)->root, __next;  \
+    while (__cur) {                     \
+        if (__cur->left) {              \
+            __next = __cur->left;       \
+            __cur->left = __next->right;\
+            __next->right = __cur;      \
+        } else {                        \
+            __next = __cur->right;      \
+            free_node( (tree), __cur ); \
+        }                               \
+        __cur = __next;                 \
+    }                                   \
+    (tree)->root = NULL;                \
+})
+
+
+/* ==============================================================================
+ *                          有序查询与游标
+ *
+ * bstree_lower_bound/bstree_upper_bound 只沿一条路径下降, 返回节点指针.
+ * 游标保存从根到当前节点路径上尚未访问的祖先(栈), 按键值从小到大移动,
+ * 从定位到遍历 k 个节点共 O(log n + k), 不修改树, 可与其他读操作并发.
+ * 使用方法:
+ *      bstree_cursor cur;
+ *      bstree_cursor_init(&cur);
+ *      for (bstree_cursor_lower_bound(&tree, &cur, &lo); bstree_cursor_get(&cur); bstree_cursor_next(&cur))
+ *          ... bstree_cursor_get(&cur)->data ...
+ *      bstree_cursor_free(&cur);
+ * 树被修改(插入, 删除)后游标失效, 需要重新定位.
+ * 普通二叉搜索树与 AVL 树通用.
+ * ============================================================================== */
+
+/**
+ * bstree_lower_bound - 查找第一个键值不小于 val 的节点
+ * @tree:   树结构体的地址
+ * @val:    键值的地址
+ * @return: 节点指针, 不存在时返回 NULL
+ */
+#define bstree_lower_bound(tree, val)   ({  \
+    typeof( (tree)->root ) __lnode = (tree)->root, __lres = NULL;   \
+    while (__lnode) {                   \
+        if ( (tree)->__compare( &__lnode->data, (val) ) >= 0 ) {    \
+            __lres = __lnode;           \
+            __lnode = __lnode->left;    \
+        } else                          \
+            __lnode = __lnode->right;   \
+    }                                   \
+    __lres;                             \
+})
+
+/**
+ * bstree_upper_bound - 查找第一个键值大于 val 的节点(val 的后继)
+ * @tree:   树结构体的地址
+ * @val:    键值的地址
+ * @return: 节点指针, 不存在时返回 NULL
+ */
+#define bstree_upper_bound(tree, val)   ({  \
+    typeof( (tree)->root ) __unode = (tree)->root, __ures = NULL;   \
+    while (__unode) {                   \
+        if ( (tree)->__compare( &__unode->data, (val) ) > 0 ) {     \
+            __ures = __unode;           \
+            __unode = __unode->left;    \
+        } else                          \
+            __unode = __unode->right;   \
+    }                                   \
+    __ures;                             \
+})
+
+/* bstree_cursor_init - 初始化游标 */
+#define bstree_cursor_init(cur)     ({  \
+    (cur)->stack = NULL;                \
+    (cur)->depth = (cur)->capacity = 0; \
+})
+
+/* bstree_cursor_free - 释放游标的栈空间 */
+#define bstree_cursor_free(cur)     ({  \
+    free_buf( (cur)->stack );           \
+    (cur)->depth = (cur)->capacity = 0; \
+})
+
+/* __bstree_cursor_push - 节点入栈, 栈满时容量翻倍 */
+#define __bstree_cursor_push(cur, node) ({  \
+    if ( (cur)->depth == (cur)->capacity ) {    \
+        (cur)->capacity = max( (cur)->capacity * 2, 32 );   \
+        (cur)->stack = realloc( (cur)->stack, (cur)->capacity * sizeof(*(cur)->stack) );    \
+        assert( (cur)->stack );         \
+    }                                   \
+    (cur)->stack[(cur)->depth++] = (node);  \
+})
+
+/* __bstree_cursor_leftmost - 将 node 及其左侧路径入栈, 栈顶为 node 子树的最小节点 */
+#define __bstree_cursor_leftmost(cur, node) ({  \
+    typeof( node ) __cnode = (node);    \
+    for (; __cnode; __cnode = __cnode->left)    \
+        __bstree_cursor_push( (cur), __cnode ); \
+})
+
+/**
+ * __bstree_cursor_seek - 从根下降, 键值满足 compare(node, val) cmp 0 的节点入栈并向左
+ * @cmp:    比较运算符, >= 定位到 lower_bound, > 定位到 upper_bound
+ */
+#define __bstree_cursor_seek(tree, cur, val, cmp)   ({  \
+    typeof( (tree)->root ) __snode = (tree)->root;  \
+    (cur)->depth = 0;                   \
+    while (__snode) {                   \
+        if ( (tree)->__compare( &__snode->data, (val) ) cmp 0 ) {   \
+            __bstree_cursor_push( (cur), __snode ); \
+            __snode = __snode->left;    \
+        } else                          \
+            __snode = __snode->right;   \
+    }                                   \
+})
+
+/* bstree_cursor_first - 游标移动到最小节点 */
+#define bstree_cursor_first(tree, cur)  ({  \
+    (cur)->depth = 0;                   \
+    __bstree_cursor_leftmost( (cur), (tree)->root );   \
+})
+
+/* bstree_cursor_lower_bound - 游标移动到第一个键值不小于 val 的节点 */
+#define bstree_cursor_lower_bound(tree, cur, val)   __bstree_cursor_seek(tree, cur, val, >=)
+
+/* bstree_cursor_upper_bound - 游标移动到第一个键值大于 val 的节点 */
+#define bstree_cursor_upper_bound(tree, cur, val)   __bstree_cursor_seek(tree, cur, val, >)
+
+/* bstree_cursor_get - 游标当前所在节点, 已越过最大节点时返回 NULL */
+#define bstree_cursor_get(cur)      ({ (cur)->depth ? (cur)->stack[(cur)->depth - 1] : NULL; })
+
+/* bstree_cursor_next - 游标移动到下一个节点(中序后继) */
+#define bstree_cursor_next(cur)     ({  \
+    typeof( *(cur)->stack ) __next = (cur)->stack[--(cur)->depth]->right;  \
+    __bstree_cursor_leftmost( (cur), __next );  \
+})
+
+/**
+ * bstree_range - 按键值从小到大访问 [lo, hi] 内的全部节点
+ * @tree:   树结构体的地址
+ * @lo:     下界的地址
+ * @hi:     上界的地址
+ * @op:     对每个节点执行的操作, 调用形式为 op(node), 不能修改树
+ */
+#define bstree_range(tree, lo, hi, op)  ({  \
+    typeof( *(tree)->root ) *__rnode;   \
+    struct {                            \
+        typeof( (tree)->root ) *stack;  \
+        int depth;                      \
+        int capacity;                   \
+    } __rcur;                           \
+    bstree_cursor_init(&__rcur);        \
+    bstree_cursor_lower_bound( (tree), &__rcur, (lo) ); \
+    while ((__rnode = bstree_cursor_get(&__rcur)) != NULL   \
+            && (tree)->__compare( &__rnode->data, (hi) ) <= 0) {    \
+        op(__rnode);                    \
+        bstree_cursor_next(&__rcur);    \
+    }                                   \
+    bstree_cursor_free(&__rcur);        \
+})
+
+
+/* ==============================================================================
+ *                          从有序数组批量构建
+ *
+ * 以区间中点为根, 一次遍历得到完全平衡的树, 时间 O(n), 不需要比较.
+ * 树配置了对象池时全部节点从一块连续内存中切分, 按键值顺序排列; 否则逐个 calloc.
+ * 树中原有节点先被释放.
+ * ============================================================================== */
+
+/* 构建栈深度, 每层最多压入左右两个区间, 树高不超过 64 */
+#define __BSTREE_BUILD_DEPTH    (2 * 64 + 2)
+
+/* __bstree_no_update - 普通二叉搜索树节点没有附加信息 */
+#define __bstree_no_update(node)    ((void)(node))
+
+/**
+ * __bstree_build_sorted - 从有序数组构建平衡树
+ *      Note:
+ *          先根顺序分配节点并挂到父节点上, 后根顺序调用 update, 保证子树先于父节点更新
+ * @tree:   树结构体的地址
+ * @array:  按 __compare 升序排列的键值数组
+ * @n:      键值个数
+ * @update: 更新节点附加信息(高度, 子树大小)
+ * @return: 无
+ */
+#define __bstree_build_sorted(tree, array, n, update)   ({  \
+    struct {                            \
+        size_t lo, hi;                  \
+        typeof( (tree)->root ) *slot;   \
+        typeof( (tree)->root ) node;    \
+    } __st[__BSTREE_BUILD_DEPTH], *__e; \
+    typeof( (tree)->root ) __block = NULL, __bn;    \
+    size_t __n = (n), __m;              \
+    int __top = 0;                      \
+\
+    bstree_clear(tree);                 \
+    if ( (tree)->pool && __n )          \
+        __block = pool_alloc_n( (tree)->pool, typeof( *__block ), __n );  \
+    if (__n)                            \
+        __st[__top++] = (typeof( *__st )){ 0, __n, &(tree)->root, NULL };  \
+    while (__top > 0) {                 \
+        __e = &__st[__top - 1];         \
+        if (__e->node == NULL) {        \
+            __m = __e->lo + (__e->hi - __e->lo) / 2;    \
+            if (__block) {              \
+                __bn = __block + __m;   \
+                __bn->data = (array)[__m];  \
+            } else                      \
+                __bn = alloc_node( (tree), (array) + __m ); \
+            *__e->slot = __e->node = __bn;  \
+            if (__m + 1 < __e->hi)      \
+                __st[__top++] = (typeof( *__st )){ __m + 1, __e->hi, &__bn->right, NULL };  \
+            if (__e->lo < __m)          \
+                __st[__top++] = (typeof( *__st )){ __e->lo, __m, &__bn->left, NULL };   \
+        } else {                        \
+            update(__e->node);          \
+            --__top;                    \
+        }                               \
+    }                                   \
+})
+
+/**
+ * bstree_build_sorted - 从有序数组构建完全平衡的二叉搜索树
+ * @tree:   树结构体的地址
+ * @array:  升序排列的键值数组
+ * @n:      键值个数
+ * @return: 无
+ */
+#define bstree_build_sorted(tree, array, n)     __bstree_build_sorted(tree, array, n, __bstree_no_update)
+
+
+/* ==============================================================================
+ *                          计数多重集合
+ *
+ * 普通二叉搜索树把相等的键值作为新节点插入左子树, 重复键值多时左侧形成长链,
+ * 删除时需要在多个副本中查找. 计数模式下每个节点保存键值的重复次数 count,
+ * 重复插入只增加计数, 不分配节点, 树高只与不同键值的个数有关.
+ * 使用方法:
+ *      1. 使用 DEFINE_MSTREE_ELEMENT_TYPE(type, node_name, tree_name) 定义,
+ *      参数与 DEFINE_BSTREE_ELEMENT_TYPE 相同
+ *      2. 插入使用 ms_insert(tree, val), 删除一个副本使用 ms_delete(tree, val),
+ *      ms_count(tree, val) 返回键值的重复次数
+ *      3. 查找, 遍历, 范围查询与普通二叉搜索树相同, 每个不同键值只访问一次, 次数为 node->count
+ * ============================================================================== */
+
+/**
+ * 定义计数多重集合节点数据域以及结构体名字
+ * @type:	    数据域类型
+ * @node_name:	节点结构体名字
+ * @tree_name:	树构体名字
+ */
+#define DEFINE_MSTREE_ELEMENT_TYPE(type, node_name, tree_name)   \
+    typedef struct node_name {          \
+        struct node_name *left;         \
+        struct node_name *right;        \
+        type data;                      \
+        unsigned int count;             \
+    } node_name;                        \
+    __DEFINE_BSTREE_TREE(node_name, tree_name)
+
+/**
+ * __ms_find_slot - 查找与 val 相等的节点
+ * @return: 指向该节点的指针的地址, 不存在时为应插入位置(*slot == NULL)
+ */
+#define __ms_find_slot(tree, val)   ({  \
+    typeof( (tree)->root ) *__mslot = &( (tree)->root );   \
+    int __mcmp;                         \
+    while (*__mslot != NULL && (__mcmp = (tree)->__compare( (val), &(*__mslot)->data )) != 0)  \
+        __mslot = __mcmp < 0 ? &(*__mslot)->left : &(*__mslot)->right;  \
+    __mslot;                            \
+})
+
+/**
+ * ms_insert - 插入键值, 已存在时计数加 1
+ * @tree:   树结构体的地址
+ * @val:    待插入键值的地址
+ * @return: 插入后该键值的重复次数
+ */
+#define ms_insert(tree, val)    ({  \
+    typeof( (tree)->root ) *__islot = __ms_find_slot( (tree), (val) );    \
+    if (*__islot == NULL) {             \
+        *__islot = alloc_node( (tree), (val) ); \
+        (*__islot)->count = 0;          \
+    }                                   \
+    ++(*__islot)->count;                \
+})
+
+/**
+ * ms_delete - 删除一个与 val 相等的键值, 计数减为 0 时删除节点
+ * @tree:   树结构体的地址
+ * @val:	待删除的键值的地址
+ * @return: 删除成功返回 true, 键值不存在返回 false
+ */
+#define ms_delete(tree, val)    ({  \
+    typeof( (tree)->root ) *__dslot = __ms_find_slot( (tree), (val) );    \
+    typeof( (tree)->root ) __dnode = *__dslot, *__rslot, __rnode;  \
+    bool __found = __dnode != NULL;     \
+    if (__found && --__dnode->count == 0) {     \
+        if (__dnode->left && __dnode->right) {  \
+            /* 左子树最右节点的键值和计数移到该节点, 转为删除最右节点 */   \
+            __rslot = &__dnode->left;   \
+            while ((*__rslot)->right)   \
+                __rslot = &(*__rslot)->right;   \
+            __rnode = *__rslot;         \
+            __dnode->data = __rnode->data;  \
+            __dnode->count = __rnode->count;\
+            *__rslot = __rnode->left;   \
+            free_node( (tree), __rnode );   \
+        } else {                        \
+            *__dslot = __dnode->left ? __dnode->left : __dnode->right;  \
+            free_node( (tree), __dnode );   \
+        }                               \
+    }                                   \
+    __found;                            \
+})
+
+/* ms_count - 键值的重复次数, 不存在返回 0 */
+#define ms_count(tree, val)     ({  \
+    typeof( (tree)->root ) __cnode = *__ms_find_slot( (tree), (val) );   \
+    __cnode ? __cnode->count : 0U;      \
+})
+
+
+/* ==============================================================================
+ *                          平衡二叉搜索树(AVL 树)
+ *
+ * 普通二叉搜索树在插入有序键值时退化为链表, AVL 树保证任意节点左右子树高度差
+ * 不超过 1, 树高为 O(log n).
+ * 使用方法:
+ *      1. 使用 DEFINE_AVLTREE_ELEMENT_TYPE(type, node_name, tree_name) 定义, 
+ *      参数与 DEFINE_BSTREE_ELEMENT_TYPE 相同
+ *      2. 插入使用 avl_insert(tree, val), 删除使用 avl_delete(tree, val),
+ *      查找直接使用 find(tree, val)
+ * ============================================================================== */
+
+/* AVL 树的最大高度, 1.44 * log2(2^64) < 96 */
+#define AVL_MAX_HEIGHT      96
+
+/**
+ * 定义 AVL 树节点数据域以及结构体名字
+ * @type:	    数据域类型
+ * @node_name:	节点结构体名字
+ * @tree_name:	树构体名字
+ */
+#define DEFINE_AVLTREE_ELEMENT_TYPE(type, node_name, tree_name)   \
+    typedef struct node_name {          \
+        struct node_name *left;         \
+        struct node_name *right;        \
+        type data;                      \
+        int height;                     \
+    } node_name;                        \
+    __DEFINE_BSTREE_TREE(node_name, tree_name)
+
+/* avl_height - 节点高度, 空树为 0 */
+#define avl_height(node)    ({ (node) ? (node)->height : 0; })
+
+/* __avl_update - 根据左右子树更新节点高度 */
+#define __avl_update(node)  ({  \
+    int __hl = avl_height( (node)->left );  \
+    int __hr = avl_height( (node)->right ); \
+    (node)->height = max(__hl, __hr) + 1;   \
+})
+
+/**
+ * __avl_rotate_right - 右旋
+ * @slot:   指向子树根的指针的地址
+ * @update: 旋转后更新节点附加信息(高度, 子树大小)
+ */
+#define __avl_rotate_right(slot, update)    ({  \
+    typeof( *(slot) ) __rx = *(slot);   \
+    typeof( *(slot) ) __ry = __rx->left;\
+    __rx->left = __ry->right;           \
+    __ry->right = __rx;                 \
+    update(__rx);                       \
+    update(__ry);                       \
+    *(slot) = __ry;                     \
+})
+
+/**
+ * __avl_rotate_left - 左旋
+ * @slot:   指向子树根的指针的地址
+ * @update: 旋转后更新节点附加信息
+ */
+#define __avl_rotate_left(slot, update)     ({  \
+    typeof( *(slot) ) __lx = *(slot);   \
+    typeof( *(slot) ) __ly = __lx->right;\
+    __lx->right = __ly->left;           \
+    __ly->left = __lx;                  \
+    update(__lx);                       \
+    update(__ly);                       \
+    *(slot) = __ly;                     \
+})
+
+/**
+ * __avl_rebalance - 更新子树高度, 左右子树高度差超过 1 时旋转恢复平衡
+ * @slot:   指向子树根的指针的地址
+ * @update: 更新节点附加信息
+ */
+#define __avl_rebalance(slot, update)   ({  \
+    typeof( *(slot) ) __bn = *(slot);   \
+    int __bf = avl_height(__bn->left) - avl_height(__bn->right);    \
+    if (__bf > 1) {                     \
+        if (avl_height(__bn->left->left) < avl_height(__bn->left->right))       \
+            __avl_rotate_left(&__bn->left, update);     \
+        __avl_rotate_right(slot, update);       \
+    } else if (__bf < -1) {             \
+        if (avl_height(__bn->right->right) < avl_height(__bn->right->left))     \
+            __avl_rotate_right(&__bn->right, update);   \
+        __avl_rotate_left(slot, update);        \
+    } else                              \
+        update(__bn);                   \
+})
+
+/**
+ * __avl_insert - 插入键值, 自底向上恢复平衡
+ * @tree:   树结构体的地址
+ * @val:    待插入键值的地址
+ * @update: 更新节点附加信息
+ * @return: 无
+ */
+#define __avl_insert(tree, val, update)     ({  \
+    typeof( (tree)->root ) *__path[AVL_MAX_HEIGHT];     \
+    typeof( (tree)->root ) *__slot = &( (tree)->root ); \
+    typeof( (tree)->root ) __new = alloc_node( (tree), (val) );  \
+    int __depth = 0;                    \
+\
+    update(__new);                      \
+    while (*__slot != NULL) {           \
+        __path[__depth++] = __slot;     \
+        if ( (tree)->__compare( &__new->data, &(*__slot)->data ) <= 0 ) __slot = &(*__slot)->left;   \
+        else __slot = &(*__slot)->right;                \
+    }                                   \
+    *__slot = __new;                    \
+\
+    /* 自底向上恢复平衡 */              \
+    while (__depth-- > 0)               \
+        __avl_rebalance(__path[__depth], update);   \
+})
+
+/**
+ * __avl_delete - 删除一个与 val 相等的键值, 自底向上恢复平衡
+ * @tree:   树结构体的地址
+ * @val:	待删除的键值的地址
+ * @update: 更新节点附加信息
+ * @return: 无
+ */
+#define __avl_delete(tree, val, update)     ({  \
+    typeof( (tree)->root ) *__path[AVL_MAX_HEIGHT];     \
+    typeof( (tree)->root ) *__slot = &( (tree)->root ); \
+    typeof( (tree)->root ) __victim;    \
+    typeof( __victim->data ) __vdata;   \
+    int __depth = 0, __cmp;             \
+\
+    while (*__slot != NULL && (__cmp = (tree)->__compare( (val), &(*__slot)->data )) != 0) {    \
+        __path[__depth++] = __slot;     \
+        __slot = __cmp < 0 ? &(*__slot)->left : &(*__slot)->right;  \
+    }                                   \
+\
+    if (*__slot != NULL) {              \
+        /* 有两个孩子时与左子树最右节点交换键值, 转为删除该节点 */ \
+        if ((*__slot)->left && (*__slot)->right) {      \
+            __victim = *__slot;         \
+            __path[__depth++] = __slot; \
+            __slot = &__victim->left;   \
+            while ((*__slot)->right) {  \
+                __path[__depth++] = __slot;     \
+                __slot = &(*__slot)->right;     \
+            }                           \
+            __vdata = __victim->data;   \
+            __victim->data = (*__slot)->data;   \
+            (*__slot)->data = __vdata;  \
+        }                               \
+        __victim = *__slot;             \
+        *__slot = __victim->left ? __victim->left : __victim->right;   \
+        free_node( (tree), __victim );  \
+\
+        while (__depth-- > 0)           \
+            __avl_rebalance(__path[__depth], update);   \
+    }                                   \
+})
+
+/* avl_insert - 向 AVL 树插入键值, 相同键值插入左子树 */
+#define avl_insert(tree, val)   __avl_insert(tree, val, __avl_update)
+
+/* avl_delete - 在 AVL 树中删除一个与 val 相等的键值 */
+#define avl_delete(tree, val)   __avl_delete(tree, val, __avl_update)
+
+/* avl_build_sorted - 从有序数组构建 AVL 树 */
+#define avl_build_sorted(tree, array, n)    __bstree_build_sorted(tree, array, n, __avl_update)
+
+
+/* ==============================================================================
+ *                          顺序统计树
+ *
+ * 在 AVL 树节点上增加子树大小 size, 插入, 删除和旋转时与高度一起维护,
+ * 第 k 小的键值(select)和小于某键值的个数(rank)均为 O(log n).
+ * 使用方法:
+ *      1. 使用 DEFINE_OSTREE_ELEMENT_TYPE(type, node_name, tree_name) 定义,
+ *      参数与 DEFINE_BSTREE_ELEMENT_TYPE 相同
+ *      2. 插入使用 os_insert(tree, val), 删除使用 os_delete(tree, val),
+ *      查找, 遍历, 范围查询与普通二叉搜索树相同
+ *      3. os_select(tree, k) 返回第 k 小(从 0 开始)的节点, os_rank(tree, val) 返回小于 val 的键值个数
+ * e.g.
+ *      p99 = os_select(&tree, (os_count(&tree) - 1) * 99 / 100)->data;
+ * ============================================================================== */
+
+/**
+ * 定义顺序统计树节点数据域以及结构体名字
+ * @type:	    数据域类型
+ * @node_name:	节点结构体名字
+ * @tree_name:	树构体名字
+ */
+#define DEFINE_OSTREE_ELEMENT_TYPE(type, node_name, tree_name)   \
+    typedef struct node_name {          \
+        struct node_name *left;         \
+        struct node_name *right;        \
+        type data;                      \
+        int height;                     \
+        unsigned int size;              \
+    } node_name;                        \
+    __DEFINE_BSTREE_TREE(node_name, tree_name)
+
+/* os_size - 子树节点个数, 空树为 0 */
+#define os_size(node)       ({ (node) ? (node)->size : 0U; })
+
+/* os_count - 树中键值个数 */
+#define os_count(tree)      os_size( (tree)->root )
+
+/* __os_update - 根据左右子树更新节点高度和子树大小 */
+#define __os_update(node)   ({  \
+    __avl_update(node);                 \
+    (node)->size = os_size( (node)->left ) + os_size( (node)->right ) + 1;  \
+})
+
+/* os_insert - 向顺序统计树插入键值 */
+#define os_insert(tree, val)    __avl_insert(tree, val, __os_update)
+
+/* os_delete - 在顺序统计树中删除一个与 val 相等的键值 */
+#define os_delete(tree, val)    __avl_delete(tree, val, __os_update)
+
+/* os_build_sorted - 从有序数组构建顺序统计树 */
+#define os_build_sorted(tree, array, n)     __bstree_build_sorted(tree, array, n, __os_update)
+
+/**
+ * os_select - 查找第 k 小的键值
+ * @tree:   树结构体的地址
+ * @k:      序号, 从 0 开始
+ * @return: 节点指针, k 不小于键值个数时返回 NULL
+ */
+#define os_select(tree, k)  ({  \
+    typeof( (tree)->root ) __snode = (tree)->root;  \
+    unsigned int __k = (k), __ls;       \
+    while (__snode) {                   \
+        __ls = os_size( __snode->left );\
+        if (__k < __ls)                 \
+            __snode = __snode->left;    \
+        else if (__k == __ls)           \
+            break;                      \
+        else {                          \
+            __k -= __ls + 1;            \
+            __snode = __snode->right;   \
+        }                               \
+    }                                   \
+    __snode;                            \
+})
+
+/**
+ * os_rank - 统计小于 val 的键值个数
+ * @tree:   树结构体的地址
+ * @val:    键值的地址
+ * @return: 键值个数, 也是第一个不小于 val 的键值的序号
+ */
+#define os_rank(tree, val)  ({  \
+    typeof( (tree)->root ) __rnode = (tree)->root;  \
+    unsigned int __rank = 0;            \
+    while (__rnode) {                   \
+        if ( (tree)->__compare( (val), &__rnode->data ) <= 0 )  \
+            __rnode = __rnode->left;    \
+        else {                          \
+            __rank += os_size( __rnode->left ) + 1; \
+            __rnode = __rnode->right;   \
+        }                               \
+    }                                   \
+    __rank;                             \
+})
+
+
+/* ==============================================================================
+ *                          多线程共享
+ *
+ * 每棵树带有一个读写锁: 查询持有读锁, 多个线程可以同时查询; 插入, 删除持有写锁.
+ * 使用方法:
+ *      1. bstree_rwlock_init(tree) 初始化读写锁, 不再使用时 bstree_rwlock_destroy(tree)
+ *      2. 常用操作直接使用 xxx_rwlock 版本, 如 find_rwlock, insert_rwlock, avl_delete_rwlock
+ *      3. 其他操作使用 bstree_read_locked(tree, stmt) 或 bstree_write_locked(tree, stmt) 包装
+ *      Note:
+ *          bstree_preorder/inorder/postorder 和 bstree_freeze 使用 Morris 遍历, 遍历期间
+ *          临时修改树, 必须持有写锁; 只读遍历使用游标或 bstree_range, 持有读锁即可.
+ *          游标在释放读锁后失效.
+ * e.g.
+ *      bstree_rwlock_init(&tree);
+ *      读线程:   if (find_rwlock(&tree, &key)) ...
+ *                bstree_read_locked(&tree, bstree_range(&tree, &lo, &hi, op));
+ *      写线程:   avl_insert_rwlock(&tree, &key);
+ *      bstree_rwlock_destroy(&tree);
+ * ============================================================================== */
+
+/**
+ * bstree_rwlock_init - 初始化读写锁, 写者优先
+ *      Note:
+ *          glibc 默认读者优先, 读线程持续查找时插入删除会一直等待
+ * @tree:   树结构体的地址
+ * @return: 成功返回1, 失败返回0
+ */
+#define bstree_rwlock_init(tree)    ({  \
+    pthread_rwlockattr_t __attr;        \
+    bool __ok = !pthread_rwlockattr_init(&__attr);  \
+    __ok = __ok && !pthread_rwlockattr_setkind_np(&__attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP) \
+                && !pthread_rwlock_init(&(tree)->rwlock, &__attr);  \
+    pthread_rwlockattr_destroy(&__attr);    \
+    __ok;                               \
+})
+
+#define bstree_rwlock_destroy(tree) ({ pthread_rwlock_destroy(&(tree)->rwlock); })
+
+/**
+ * bstree_read_locked - 持有读锁执行 stmt
+ * @tree:   树结构体的地址
+ * @stmt:   只读操作, 结果通过赋值带出, 如 bstree_read_locked(&tree, r = os_rank(&tree, &x))
+ */
+#define bstree_read_locked(tree, stmt)  ({  \
+    pthread_rwlock_rdlock(&(tree)->rwlock); \
+    stmt;                               \
+    pthread_rwlock_unlock(&(tree)->rwlock); \
+})
+
+/**
+ * bstree_write_locked - 持有写锁执行 stmt
+ * @tree:   树结构体的地址
+ * @stmt:   修改操作, 结果通过赋值带出, 如 bstree_write_locked(&tree, ok = ms_delete(&tree, &x))
+ */
+#define bstree_write_locked(tree, stmt) ({  \
+    pthread_rwlock_wrlock(&(tree)->rwlock); \
+    stmt;                               \
+    pthread_rwlock_unlock(&(tree)->rwlock); \
+})
+
+/* find_rwlock - 查找(持有读锁) */
+#define find_rwlock(tree, val)  ({  \
+    bool __found;                       \
+    bstree_read_locked(tree, __found = find(tree, val));    \
+    __found;                            \
+})
+
+#define insert_rwlock(tree, val)        bstree_write_locked(tree, insert(tree, val))
+#define delete_rwlock(tree, val)        bstree_write_locked(tree, delete(tree, val))
+#define avl_insert_rwlock(tree, val)    bstree_write_locked(tree, avl_insert(tree, val))
+#define avl_delete_rwlock(tree, val)    bstree_write_locked(tree, avl_delete(tree, val))
+#define os_insert_rwlock(tree, val)     bstree_write_locked(tree, os_insert(tree, val))
+#define os_delete_rwlock(tree, val)     bstree_write_locked(tree, os_delete(tree, val))
+
+/* ms_insert_rwlock - 插入键值(持有写锁), 返回插入后该键值的重复次数 */
+#define ms_insert_rwlock(tree, val)  ({ \
+    unsigned int __cnt;                 \
+    bstree_write_locked(tree, __cnt = ms_insert(tree, val));    \
+    __cnt;                              \
+})
+
+/* ms_delete_rwlock - 删除一个键值(持有写锁), 删除成功返回 true, 键值不存在返回 false */
+#define ms_delete_rwlock(tree, val)  ({ \
+    bool __ok;                          \
+    bstree_write_locked(tree, __ok = ms_delete(tree, val));     \
+    __ok;                               \
+})
+
+/* ==============================================================================
+ *                          静态查找表(Eytzinger 布局)
+ *
+ * 将只读的键值集合冻结为按层序(BFS)排列的数组: keys[1] 为根, keys[k] 的左右孩子为
+ * keys[2k], keys[2k + 1]. 查找时没有指针追逐, 前几层始终在缓存中, 并且可以提前
+ * 预取若干层之后的孩子(连续存放在同一缓存行内); 比较结果直接参与下标计算, 没有分支.
+ * 使用方法:
+ *      1. 使用 DEFINE_EYTZINGER_ELEMENT_TYPE(type, name) 定义, type 与树的数据域类型相同
+ *      2. bstree_freeze(tree, E) 从树(普通, AVL, 顺序统计树均可)冻结,
+ *      eyt_build_sorted(E, array, n, compare) 从有序数组构建
+ *      3. eyt_lower_bound(E, val) 返回第一个不小于 val 的键值下标, 不存在返回 0,
+ *      eyt_key(E, k) 获取键值; eyt_find(E, val) 判断是否存在
+ *      4. xxx_cmp(..., cmp, prefetch) 使用编译期比较 cmp(a, b), prefetch 为 true 时预取
+ * e.g.
+ *      DEFINE_EYTZINGER_ELEMENT_TYPE(double, eyt_index);
+ *      eyt_index E;
+ *      bstree_freeze(&tree, &E);
+ *      if (eyt_find(&E, &key)) ...
+ *      eyt_free(&E);
+ * ============================================================================== */
+
+/**
+ * @keys:       按层序排列的键值, 从下标 1 开始, 按缓存行对齐
+ * @n:          键值个数
+ * @__compare:  函数指针, 比较键值的大小
+ */
+#define DEFINE_EYTZINGER_ELEMENT_TYPE(type, name)   \
+    typedef struct name {               \
+        type *keys;                     \
+        size_t n;                       \
+        __compare_fn __compare;         \
+    } name
+
+/* __eyt_first - 中序第一个(最小键值)的下标 */
+static inline size_t __eyt_first(size_t n)
+{
+    size_t k = 1;
+
+    if (n == 0)     return 0;
+    while (2 * k <= n)
+        k *= 2;
+    return k;
+}
+
+/* __eyt_next - 中序下一个的下标, 已是最后一个时返回 0 */
+static inline size_t __eyt_next(size_t k, size_t n)
+{
+    if (2 * k + 1 <= n) {
+        k = 2 * k + 1;
+        while (2 * k <= n)
+            k *= 2;
+    } else
+        k >>= __builtin_ffsll(~(unsigned long long)k);  /* 向上越过全部右孩子边, 再上一层 */
+    return k;
+}
+
+/* __eyt_alloc - 分配按缓存行对齐的键值数组 */
+#define __eyt_alloc(E, num)    ({  \
+    size_t __bytes = ( ((num) + 1) * sizeof(*(E)->keys) + CACHELINE_SIZE - 1 ) & ~(size_t)(CACHELINE_SIZE - 1); \
+    (E)->n = (num);                     \
+    (E)->keys = aligned_alloc(CACHELINE_SIZE, __bytes); \
+    assert( (E)->keys );                \
+})
+
+/* eyt_free - 释放键值数组 */
+#define eyt_free(E)     ({ free_buf( (E)->keys ); (E)->n = 0; })
+
+/**
+ * eyt_build_sorted - 从有序数组构建
+ * @E:          静态查找表
+ * @array:      按 compare 升序排列的键值数组
+ * @num:        键值个数
+ * @compare:    比较函数
+ */
+#define eyt_build_sorted(E, array, num, compare)  ({  \
+    size_t __i, __k;                    \
+    __eyt_alloc( (E), (num) );          \
+    (E)->__compare = (compare);         \
+    for (__i = 0, __k = __eyt_first( (E)->n ); __k; ++__i, __k = __eyt_next(__k, (E)->n))   \
+        (E)->keys[__k] = (array)[__i];  \
+})
+
+/* bstree_freeze 中使用的遍历操作, 引用 bstree_freeze 中的局部变量 */
+#define __eyt_count_op(node)    (++__fn)
+#define __eyt_fill_op(node)     ({ __fE->keys[__fk] = (node)->data; __fk = __eyt_next(__fk, __fE->n); })
+
+/**
+ * bstree_freeze - 将树中全部键值按 Eytzinger 布局复制到静态查找表, 树保持不变
+ *      Note:
+ *          两次 Morris 中序遍历(计数, 填充), 不需要额外空间
+ * @tree:   树结构体的地址
+ * @E:      静态查找表, 其 keys 类型与树的数据域相同
+ */
+#define bstree_freeze(tree, E)  ({  \
+    typeof( E ) __fE = (E);             \
+    size_t __fn = 0, __fk;              \
+    bstree_inorder( (tree), __eyt_count_op );   \
+    __eyt_alloc(__fE, __fn);            \
+    __fE->__compare = (tree)->__compare;\
+    __fk = __eyt_first(__fn);           \
+    bstree_inorder( (tree), __eyt_fill_op );    \
+})
+
+/* eyt_key - 下标 k 处的键值 */
+#define eyt_key(E, k)   ( (E)->keys[k] )
+
+/**
+ * eyt_lower_bound_cmp - 查找第一个不小于 val 的键值
+ *      Note:
+ *          一个缓存行可容纳 B 个键值时, 第 k 个节点往下 log2(B) 层的全部后代
+ *          keys[B * k] ~ keys[B * k + B - 1] 位于同一缓存行, 提前预取以掩盖访存延迟
+ * @E:          静态查找表
+ * @val:        键值的地址
+ * @cmp:        比较操作, 调用形式为 cmp(a, b), a, b 为键值地址
+ * @prefetch:   是否预取
+ * @return:     键值下标, 不存在返回 0
+ */
+#define eyt_lower_bound_cmp(E, val, cmp, prefetch)    ({  \
+    const typeof( *(E)->keys ) *__ekeys = (E)->keys;    \
+    const size_t __en = (E)->n;         \
+    const size_t __eb = max(CACHELINE_SIZE / sizeof(*__ekeys), (size_t)1);  \
+    size_t __ek = 1;                    \
+    while (__ek <= __en) {              \
+        if (prefetch)                   \
+            __builtin_prefetch(__ekeys + __eb * __ek);  \
+        __ek = 2 * __ek + ( cmp( __ekeys + __ek, (val) ) < 0 );  \
+    }                                   \
+    __ek >> __builtin_ffsll(~(unsigned long long)__ek); \
+})
+
+/* eyt_lower_bound - 使用函数指针比较, 预取 */
+#define __eyt_fn_cmp(a, b)      __ecmp( (a), (b) )
+#define eyt_lower_bound(E, val)     ({  \
+    __compare_fn __ecmp = (E)->__compare;   \
+    eyt_lower_bound_cmp( (E), (val), __eyt_fn_cmp, true );  \
+})
+
+/**
+ * eyt_find_cmp - 判断键值是否存在
+ * @return: 存在返回 true, 否则返回 false
+ */
+#define eyt_find_cmp(E, val, cmp, prefetch)   ({  \
+    size_t __fidx = eyt_lower_bound_cmp( (E), (val), cmp, prefetch );   \
+    __fidx && cmp( (E)->keys + __fidx, (val) ) == 0;    \
+})
+
+#define eyt_find(E, val)     ({  \
+    __compare_fn __ecmp = (E)->__compare;   \
+    eyt_find_cmp( (E), (val), __eyt_fn_cmp, true ); \
+})
+
+#endif // !__BSTREE_H__
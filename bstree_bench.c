@@ -0,0 +1,315 @@
+/***************************************************************
+Copyright © wkangk <wangkangchn@163.com>
+文件名		: bstree_bench.c
+作者	  	: wkangk <wangkangchn@163.com>
+版本	   	: v1.0
+描述	   	: 普通二叉搜索树与 AVL 树有序插入性能对比, 从有序数组批量构建,
+            以及冻结为 Eytzinger 布局静态查找表后的查找性能,
+            多个读线程 find_rwlock 与写线程 avl_insert_rwlock/avl_delete_rwlock,
+            ms_insert_rwlock/ms_delete_rwlock 并发时的吞吐量与正确性
+时间	   	: 2026-10-18 09:30
+***************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include "tools.h"
+#include "bstree.h"
+
+DEFINE_BSTREE_ELEMENT_TYPE(double, bstree_node, bstree);
+DEFINE_AVLTREE_ELEMENT_TYPE(double, avltree_node, avltree);
+DEFINE_MSTREE_ELEMENT_TYPE(double, mstree_node, mstree);
+DEFINE_EYTZINGER_ELEMENT_TYPE(double, eyt_index);
+
+#define double_cmp(a, b)    ( (*(a) > *(b)) - (*(a) < *(b)) )
+
+int compare(const void *arg1, const void *arg2)
+{
+    double __arg1 = *(double *)arg1;
+    double __arg2 = *(double *)arg2;
+
+    if (fabs(__arg1 - __arg2) < 1e-8)   return 0;
+    else if (__arg1 < __arg2)           return -1;
+    else                                return 1;
+}
+
+/* 树高(递归, 仅用于统计) */
+#define DEFINE_TREE_HEIGHT(node_type)                       \
+    static int node_type ## _height(node_type *node)        \
+    {                                                       \
+        int hl, hr;                                         \
+        if (node == NULL)   return 0;                       \
+        hl = node_type ## _height(node->left);              \
+        hr = node_type ## _height(node->right);             \
+        return max(hl, hr) + 1;                             \
+    }
+
+DEFINE_TREE_HEIGHT(bstree_node)
+DEFINE_TREE_HEIGHT(avltree_node)
+
+/* 节点个数(递归, 仅用于统计) */
+static int avltree_node_size(avltree_node *node)
+{
+    return node ? avltree_node_size(node->left) + avltree_node_size(node->right) + 1 : 0;
+}
+
+const int N = 20000;
+const int LARGE_N = 1 << 22;    /* 静态查找表测试的键值个数, 远大于缓存 */
+
+#define NREADERS    3
+#define NWRITERS    2
+#define MS_KEYS     16          /* 写线程共同使用的重复键值个数 */
+const int RW_N = 1 << 16;       /* 预先插入的键值个数, 读线程只查找这些键值 */
+const int RW_OPS = 1 << 14;     /* 每个写线程插入的键值个数, 其中一半随后删除 */
+
+static avltree rw_tree;
+static mstree ms_tree;
+static int rw_base;             /* 本轮写线程插入的第一个键值 */
+static bool rw_done;            /* 写线程全部结束 */
+static long rw_reads, rw_errors;
+
+/* 墙上时间(秒), clock() 统计的是所有线程的 CPU 时间 */
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* 读线程: 随机查找预先插入的键值直到写线程结束, 每次都必须命中 */
+static void *rw_reader(void *arg)
+{
+    unsigned int seed = (unsigned int)(long)arg;
+    long reads = 0, errors = 0;
+    double key;
+
+    while (!__atomic_load_n(&rw_done, __ATOMIC_ACQUIRE)) {
+        key = (double)(rand_r(&seed) % RW_N);
+        errors += !find_rwlock(&rw_tree, &key);
+        ++reads;
+    }
+    __atomic_add_fetch(&rw_reads, reads, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&rw_errors, errors, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+/**
+ * rw_writer - 写线程 id 插入 [rw_base + id * RW_OPS, rw_base + (id + 1) * RW_OPS), 
+ * 再删除其中的奇数偏移; 同时在 ms_tree 中对共享的重复键值插入再删除, 检查返回值
+ */
+static void *rw_writer(void *arg)
+{
+    long id = (long)arg, errors = 0;
+    double key;
+    int i;
+
+    for (i = 0; i < RW_OPS; ++i) {
+        key = (double)(rw_base + id * RW_OPS + i);
+        avl_insert_rwlock(&rw_tree, &key);
+        key = (double)(i % MS_KEYS);
+        errors += ms_insert_rwlock(&ms_tree, &key) == 0;
+    }
+    for (i = 1; i < RW_OPS; i += 2) {
+        key = (double)(rw_base + id * RW_OPS + i);
+        avl_delete_rwlock(&rw_tree, &key);
+    }
+    /* 本线程插入的每个重复键值仍未删除, 删除必然成功 */
+    for (i = 0; i < RW_OPS; ++i) {
+        key = (double)(i % MS_KEYS);
+        errors += !ms_delete_rwlock(&ms_tree, &key);
+    }
+    __atomic_add_fetch(&rw_errors, errors, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+/**
+ * bench_rwlock - nreaders 个读线程与 NWRITERS 个写线程并发, 输出读写吞吐量,
+ * 结束后检查键值个数, 剩余键值与重复计数
+ * @nreaders:   读线程个数
+ */
+static void bench_rwlock(int nreaders)
+{
+    pthread_t readers[NREADERS], writers[NWRITERS];
+    double start, elapsed, key;
+    long i, expect, missing = 0;
+    int size;
+
+    rw_reads = rw_errors = 0;
+    rw_done = false;
+    start = now();
+    for (i = 0; i < nreaders; ++i)
+        pthread_create(readers + i, NULL, rw_reader, (void *)(i + 1));
+    for (i = 0; i < NWRITERS; ++i)
+        pthread_create(writers + i, NULL, rw_writer, (void *)i);
+    for (i = 0; i < NWRITERS; ++i)
+        pthread_join(writers[i], NULL);
+    __atomic_store_n(&rw_done, true, __ATOMIC_RELEASE);
+    for (i = 0; i < nreaders; ++i)
+        pthread_join(readers[i], NULL);
+    elapsed = now() - start;
+
+    /* 偶数偏移的键值保留, 奇数偏移的键值已删除 */
+    for (i = 0; i < NWRITERS * RW_OPS; ++i) {
+        key = (double)(rw_base + i);
+        missing += find(&rw_tree, &key) != (i % 2 == 0);
+    }
+    for (i = 0; i < MS_KEYS; ++i) {
+        key = (double)i;
+        missing += ms_count(&ms_tree, &key) != 0;
+    }
+    key = 0;
+    missing += ms_delete_rwlock(&ms_tree, &key);    /* 键值已不存在 */
+    rw_base += NWRITERS * RW_OPS;
+    expect = RW_N + (rw_base - RW_N) / 2;
+    size = avltree_node_size(rw_tree.root);
+    printf("	%d 读 %d 写: 读 %6.2f M ops/s, 写 %6.2f M ops/s, 键值 %d 个(应为 %ld), 错误 %ld 次%s\n",
+            nreaders, NWRITERS, rw_reads / elapsed / 1e6,
+            NWRITERS * RW_OPS * 3.5 / elapsed / 1e6,   /* avl 插入 1, 删除 0.5, ms 插入删除各 1 */
+            size, expect, rw_errors + missing,
+            size == expect && rw_errors + missing == 0 ? "" : " (错误!)");
+}
+
+/**
+ * bench - 以 keys 的顺序插入 n 个键值, 再全部查找一遍
+ * @tree:       树
+ * @tree_insert:插入宏
+ * @tree_height:树高统计函数
+ * @keys:       键值数组
+ * @n:          键值个数
+ */
+#define bench(tree, tree_insert, tree_height, keys, n)   ({  \
+    int __i, __hit = 0;                 \
+    double __start;                     \
+    printf("\t插入: ");                \
+    __start = START();                  \
+    for (__i = 0; __i < (n); ++__i)     \
+        tree_insert( (tree), (keys) + __i );    \
+    FINISH(__start);                    \
+    printf("\t查找: ");                \
+    __start = START();                  \
+    for (__i = 0; __i < (n); ++__i)     \
+        __hit += find( (tree), (keys) + __i );  \
+    FINISH(__start);                    \
+    printf("\t命中: %d, 树高: %d\n", __hit, tree_height( (tree)->root ));   \
+})
+
+int main(int argc, char *argv[])
+{
+    int i;
+    double *sorted = calloc_buf(N, double);
+    double *shuffled = calloc_buf(N, double);
+
+    srand(time(NULL));
+    for (i = 0; i < N; ++i)
+        sorted[i] = shuffled[i] = (double)i;
+    for (i = N - 1; i > 0; --i)
+        swap(shuffled + i, shuffled + rand() % (i + 1));
+
+    bstree tree = { .root = NULL, .__compare = compare };
+    avltree avl = { .root = NULL, .__compare = compare };
+
+    printf("有序插入 %d 个键值\n", N);
+    printf("bstree:\n");
+    bench(&tree, insert, bstree_node_height, sorted, N);
+    bstree_clear(&tree);
+
+    printf("avltree:\n");
+    bench(&avl, avl_insert, avltree_node_height, sorted, N);
+    bstree_clear(&avl);
+
+    printf("随机插入 %d 个键值\n", N);
+    printf("bstree:\n");
+    bench(&tree, insert, bstree_node_height, shuffled, N);
+    bstree_clear(&tree);
+
+    printf("avltree:\n");
+    bench(&avl, avl_insert, avltree_node_height, shuffled, N);
+
+    /* 删除一半后检查平衡 */
+    for (i = 0; i < N; i += 2)
+        avl_delete(&avl, sorted + i);
+    printf("avltree 删除一半后树高: %d\n", avltree_node_height(avl.root));
+    bstree_clear(&avl);
+
+    /* 从有序数组批量构建, 节点来自对象池中的一块连续内存 */
+    double start;
+    obj_pool pool;
+    pool_init(&pool, bstree_node, 64);
+    tree.pool = &pool;
+    printf("有序数组批量构建 %d 个键值\n", N);
+    printf("bstree:\n\t构建: ");
+    start = START();
+    bstree_build_sorted(&tree, sorted, N);
+    FINISH(start);
+    printf("\t查找: ");
+    start = START();
+    for (i = 0; i < N; ++i)
+        find(&tree, shuffled + i);
+    FINISH(start);
+    printf("\t树高: %d\n", bstree_node_height(tree.root));
+    pool_reset(&pool);
+    tree.root = NULL;
+
+    /* 大规模只读集合: 树查找与冻结为 Eytzinger 布局后查找的对比 */
+    double *large = calloc_buf(LARGE_N, double);
+    double *queries = calloc_buf(LARGE_N, double);
+    eyt_index E;
+    int hit;
+    for (i = 0; i < LARGE_N; ++i) {
+        large[i] = (double)i;
+        queries[i] = (double)(rand() % LARGE_N);
+    }
+    bstree_build_sorted(&tree, large, LARGE_N);
+    bstree_freeze(&tree, &E);
+
+    printf("%d 个键值随机查找\n", LARGE_N);
+    printf("\tbstree find: ");
+    start = START();
+    for (i = 0, hit = 0; i < LARGE_N; ++i)
+        hit += find(&tree, queries + i);
+    FINISH(start);
+    printf("\teytzinger 函数指针: ");
+    start = START();
+    for (i = 0, hit = 0; i < LARGE_N; ++i)
+        hit += eyt_find(&E, queries + i);
+    FINISH(start);
+    printf("\teytzinger 编译期比较: ");
+    start = START();
+    for (i = 0, hit = 0; i < LARGE_N; ++i)
+        hit += eyt_find_cmp(&E, queries + i, double_cmp, false);
+    FINISH(start);
+    printf("\teytzinger 编译期比较 + 预取: ");
+    start = START();
+    for (i = 0, hit = 0; i < LARGE_N; ++i)
+        hit += eyt_find_cmp(&E, queries + i, double_cmp, true);
+    FINISH(start);
+    printf("\t命中: %d\n", hit);
+
+    eyt_free(&E);
+    pool_reset(&pool);
+
+    /* 读写锁: 读线程并发查找, 写线程插入删除 */
+    rw_tree = (avltree){ .root = NULL, .__compare = compare };
+    ms_tree = (mstree){ .root = NULL, .__compare = compare };
+    if (!bstree_rwlock_init(&rw_tree) || !bstree_rwlock_init(&ms_tree))
+        return 1;
+    for (i = 0; i < RW_N; ++i) {
+        double key = (double)i;
+        avl_insert(&rw_tree, &key);
+    }
+    rw_base = RW_N;
+    printf("读写锁, 预先插入 %d 个键值, 每个写线程插入 %d 个再删除一半:\n", RW_N, RW_OPS);
+    bench_rwlock(1);
+    bench_rwlock(NREADERS);
+    bstree_rwlock_destroy(&rw_tree);
+    bstree_rwlock_destroy(&ms_tree);
+    bstree_clear(&rw_tree);
+    bstree_clear(&ms_tree);
+    free_buf(large);
+    free_buf(queries);
+    free_buf(sorted);
+    free_buf(shuffled);
+    return 0;
+}
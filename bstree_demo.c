@@ -15,10 +15,12 @@ Copyright © wkangk <wangkangchn@163.com>
 #include "log.h"
 #include "list.h"
 #include "bstree.h"
-#include "stack.h"
+#include "wsdeque.h"
 
 /* 1. 定义树节点数据域类型, 树节点名字, 数名字 */
 DEFINE_BSTREE_ELEMENT_TYPE(double, bstree_node, bstree);
+DEFINE_OSTREE_ELEMENT_TYPE(double, ostree_node, ostree);
+DEFINE_MSTREE_ELEMENT_TYPE(double, mstree_node, mstree);
 
 /* 2. 定义树节点间的大小关系
     arg1 == arg2:   0
@@ -36,122 +38,67 @@ int compare(const void *arg1, const void *arg2)
 }
 
 /**
- * traversal - 遍历树(先根法)
- * @tree:	待遍历的树
- * @id:     节点编号
- * @father: 父节点编号
- * @type:   遍历类型(先根和后根)
- * @op:     遍历过程中执行的操作
+ * clear_up_tree - 清空树
+ * @tree:	待删除的树
  * @return: 无
  */
-void traversal(bstree_node *tree, enum TraversalType type, void (*op)(bstree_node **))
+void clear_up_tree(bstree *tree)
 {   
-    /* 1. 递归退出条件 */
-    if (tree == NULL) {
+    /* 节点来自对象池时一次性释放 */
+    if (tree->pool) {
+        pool_reset(tree->pool);
+        tree->root = NULL;
         return;
     }
 
-    /* 2. 输出前序遍历结果 */
-    if (type == PRE_ORDER) 
-        op(&tree);
-    
-    /* 3. 遍历左右子树 */
-    traversal(tree->left, type, op);
-    if (type == IN_ORDER) 
-        op(&tree);
-    traversal(tree->right, type, op);
-
-    if (type == POST_ORDER) 
-        op(&tree);
+    bstree_clear(tree);
 }
 
-#define free_node(node) ({  \
-    if ((node)) {   \
-        free_buf((node)->data); \
-        free_buf((node));       \
-    }   \
-})
-
-
-
 /**
- * clear_up_tree_node - 清空树节点
- * @tree:	待删除的树
- * @return: 无
- */
-void clear_up_tree_node(bstree_node *tree)
-{   
-    if (tree) {
-        /* 从左子树退出时清空左子树 */
-        clear_up_tree_node(tree->left);
-        free_node(tree->left);
-
-        /* 从右子树退出时清空右子树和根 */
-        clear_up_tree_node(tree->right);
-        free_node(tree->right);
-    }
-}
-
-/**
- * clear_up_tree - 清空树
- * @tree:	待删除的树
+ * show - 显示节点键值
+ * @node:   节点
  * @return: 无
  */
-void clear_up_tree(bstree *tree)
-{   
-    clear_up_tree_node(tree->root);
-    free_buf(tree->root->data);
-    free_buf(tree->root);
-}
-
-// #define MAX  1024
-// DEFINE_STACK_ELEMENT_TYPE(bstree_node, stack);
-// void clear_up_tree_node1(bstree *tree)
-// {   
-//     struct stack *S = calloc(1, sizeof(struct stack));
-// 	printf("%d\n", init(S, MAX));
+static inline void show(bstree_node *node) { printf("%lf ", node->data); }
 
-//     bstree_node *node = tree->root;
-//     spush(S, node);
-//     while(!sis_empty(S)) {
-//         node = spop(S);
+/* show_count - 显示多重集合节点键值及其重复次数 */
+static inline void show_count(mstree_node *node) { printf("%.0lf x %u  ", node->data, node->count); }
 
-//         if (node->left) {
-//             spush(S, node);
-//             spush(S, node->left);   /* 左 根 */
-//             node = node->left;
-//             continue;
-//         } else {
-//             /* 左子树不存在, 处理 */
+#define NTHREADS    4
+#define PAR_NODES   (1 << 16)       /* 并行遍历的树节点个数 */
+#define PAR_WORK    2000            /* 每个节点模拟的计算量 */
 
-
-//             if (node->right) {
-//                 spush(S, node->right);   /* 左 根 */
-//                 node = node->left;
-//                 continue;
-//             }
-//         }
-//     }
-
-
-
-//     if (tree) {
-//         /* 从左子树退出时清空左子树 */
-//         clear_up_tree_node(tree->left);
-//         free_node(tree->left);
-
-//         /* 从右子树退出时清空右子树和根 */
-//         clear_up_tree_node(tree->right);
-//         free_node(tree->right);
-//     }
-// }
+/* 每个线程的部分结果, 按缓存行对齐, 各线程写入不同的缓存行, 避免伪共享 */
+struct sum_part {
+    double sum;
+    double work;
+    int count;
+} __cacheline_aligned;
 
 /**
- * show - 显示节点键值
- * @node:   节点
+ * sum_node - 并行遍历的任务函数, 累加节点键值并派生左右子树
+ * @w:      当前工作线程, w->arg 为 struct sum_part 数组
+ * @item:   树节点
  * @return: 无
  */
-static inline void show(bstree_node **node) { printf("%lf ", *(*node)->data); }
+static void sum_node(ws_worker *w, void *item)
+{
+    bstree_node *node = item;
+    struct sum_part *part = (struct sum_part *)w->arg + w->id;
+    double x = node->data;
+
+    /* 模拟每个节点的计算, 使遍历时间足够长, 其他线程启动后有任务可窃取 */
+    for (int k = 0; k < PAR_WORK; ++k)
+        x = x * 0.5 + 1;
+    part->work += x;
+    part->sum += node->data;
+    ++part->count;
+    if (node->left)     ws_spawn(w, node->left);
+    if (node->right)    ws_spawn(w, node->right);
+}
+
+static double serial_sum;
+static inline void add(bstree_node *node) { serial_sum += node->data; }
 
 
 const int UPPER = 4000;
@@ -162,9 +109,14 @@ int main(int argc, char *argv[])
     int key;
     double _key;
     
+    /* 节点从对象池中分配(可选) */
+    obj_pool pool;
+    pool_init(&pool, bstree_node, 64);
+
     bstree tree = {
         .root = NULL,
         .__compare = compare,
+        .pool = &pool,
     };
 
     srand(time(NULL)); /* 根据当前时间设置随机种子 */
@@ -177,8 +129,70 @@ int main(int argc, char *argv[])
 
     /* 4. 遍历 */
     printf("中序遍历: \n"); 
-    traversal(tree.root, IN_ORDER, show);
+    bstree_inorder(&tree, show);
+    printf("\n");
+
+    /* 并行遍历: 根结点交给 0 号线程, 其他线程访问的节点都来自窃取的子树 */
+    obj_pool par_pool;
+    pool_init(&par_pool, bstree_node, 4096);
+    bstree par_tree = { .root = NULL, .__compare = compare, .pool = &par_pool };
+    struct sum_part part[NTHREADS] = { 0 };
+    double sum = 0;
+    int count = 0;
+
+    for (i = 0; i < PAR_NODES; ++i) {
+        _key = (double)rand();
+        insert(&par_tree, &_key);
+    }
+    ws_run(NTHREADS, sum_node, par_tree.root, part);
+    for (i = 0; i < NTHREADS; ++i) {
+        printf("线程 %d 访问 %d 个节点%s\n", i, part[i].count, i && part[i].count ? "(窃取)" : "");
+        sum += part[i].sum;
+        count += part[i].count;
+    }
+    bstree_inorder(&par_tree, add);
+    printf("并行遍历: %d 个节点, 键值和 %lf, 串行遍历键值和 %lf\n", count, sum, serial_sum);
+    clear_up_tree(&par_tree);
+
+    /* 范围查询: 只访问 [lo, hi] 内的节点 */
+    double lo = 1000, hi = 1200;
+    printf("[%lf, %lf] 内的键值: \n", lo, hi);
+    bstree_range(&tree, &lo, &hi, show);
+    printf("\n");
+
+    /* 游标: 从 lo 的后继开始按顺序取 5 个键值 */
+    bstree_cursor cur;
+    bstree_cursor_init(&cur);
+    printf("%lf 之后的 5 个键值: \n", lo);
+    for (bstree_cursor_upper_bound(&tree, &cur, &lo), i = 0; bstree_cursor_get(&cur) && i < 5; bstree_cursor_next(&cur), ++i)
+        show(bstree_cursor_get(&cur));
+    printf("\n");
+    bstree_cursor_free(&cur);
+
+    /* 顺序统计: O(log n) 求分位数和排名 */
+    ostree os = { .root = NULL, .__compare = compare };
+    for (i = 0; i < 1000; ++i) {
+        _key = (double)(rand() % UPPER);
+        os_insert(&os, &_key);
+    }
+    printf("p50: %lf, p99: %lf, 小于 %lf 的键值个数: %u\n",
+            os_select(&os, (os_count(&os) - 1) * 50 / 100)->data,
+            os_select(&os, (os_count(&os) - 1) * 99 / 100)->data,
+            lo, os_rank(&os, &lo));
+    bstree_clear(&os);
+
+    /* 计数多重集合: 重复键值只增加计数 */
+    mstree ms = { .root = NULL, .__compare = compare };
+    for (i = 0; i < 1000; ++i) {
+        _key = (double)(rand() % 10);
+        ms_insert(&ms, &_key);
+    }
+    _key = 0;
+    ms_delete(&ms, &_key);
+    printf("多重集合(删除一个 0 后): \n");
+    bstree_inorder(&ms, show_count);
     printf("\n");
+    bstree_clear(&ms);
 
     /* 5. 查找和删除 */
     for (i = 0; i < 100; ++i) {
@@ -194,7 +208,7 @@ int main(int argc, char *argv[])
     }
 
     printf("\n删除后中序遍历: \n"); 
-    traversal(tree.root, IN_ORDER, show);
+    bstree_inorder(&tree, show);
     printf("\n");
 
     /* 6. 清空树 */
@@ -202,7 +216,7 @@ int main(int argc, char *argv[])
     printf("%p\n", tree.root);
 
     printf("\n清空后中序遍历: %p\n", tree.root); 
-    traversal(tree.root, IN_ORDER, show);
+    bstree_inorder(&tree, show);
     printf("\n");
 
     return 0;
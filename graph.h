@@ -10,6 +10,8 @@ Copyright © wkangk <wangkangchn@163.com>
 #define __GRAPH_H__ 
 #include "tools.h"
 #include "list.h"
+#include <stdbool.h>
+#include <pthread.h>
 
 #define __iteration__(count)    \
     for (size_t i = 0; i < count; ++i) 
@@ -48,6 +50,21 @@ typedef struct Edge {
     __node->w = (wight);                              \
     list_add_tail(&(__node->list), &(( (G) + (s))->list)); })
 
+/**
+ * insert_pool - 向邻接表中插入节点, 节点从对象池中分配
+ * @G:      图(邻接表)
+ * @s:      待插入边的左顶点
+ * @t:      与 s 邻接的顶点
+ * @w:      权
+ * @P:      _adj_node_ 类型的对象池
+ * @return: 无
+ */
+#define insert_pool(G, s, t, wight, P) ({     \
+    _adj_node_ *__node = pool_alloc( (P), _adj_node_ );   \
+    __node->id = (t);                        \
+    __node->w = (wight);                              \
+    list_add_tail(&(__node->list), &(( (G) + (s))->list)); })
+
 /**
  * clear_list - 释放队列节点
  * @header:	待清理链表的头指针
@@ -74,6 +91,18 @@ typedef struct Edge {
         clear_list(&(( (G) + i)->list));   \
 })
 
+/**
+ * clear_G_pool - 释放图中节点空间(节点由 insert_pool 分配), 释放后邻接表为空
+ * @G:	    图(邻接表)
+ * @count:  图中节点个数
+ * @P:      插入时使用的对象池
+ * @return: 无
+ */
+#define clear_G_pool(G, count, P)   ({  \
+    pool_reset( (P) );                  \
+    init( (G), (count) );               \
+})
+
 /**
  * init - 初始化队列头邻接表
  * @G:	    图
@@ -102,9 +131,9 @@ typedef struct Edge {
                 __temp = 0;           \
             *(((int *)(matrix) + __i * (n)) + __j) = __temp;  \
         }   \
-    for (__i = 0; __i < n; ++__i)     \
-        list_for_each_entry(node, &(( (G) + __i)->list), list)   \
-            *(((int *)(matrix) + __i * (n)) + node->id) = node->w;    \
+    for (__i = 0; __i < (n); ++__i)     \
+        list_for_each_entry(__node, &(( (G) + __i)->list), list)   \
+            *(((int *)(matrix) + __i * (n)) + __node->id) = __node->w;    \
 })
 
 
@@ -163,35 +192,679 @@ typedef struct Edge {
 
 
 
-// /**
-//  * bfs - 广度优先搜索得到从顶点1到某个顶点的最短距离
-//  * @G:      图(邻接表表示)	
-//  * @id:     搜索的起点
-//  * @id:     节点上执行的操作
-//  * @return: 无
-//  */
-// #define bfs(G, s, op) ({    \
-//     _Vertex_ *_vertex; \
-//     _adj_node_ *_node; \
-//     int vertex_id, dist = -1;   \
-//     queue *_Q = calloc_buf(1, queue);    \
-//     assert(qinit(_Q, MAX));  \
-//     ((G) + (s))->dist = 0;  \
-//     qpush(_Q, (s));\
-//     while(!qis_empty(_Q)) {      \
-//         vertex_id = qpop(_Q);        \
-//         _vertex = (G) + vertex_id;   \
-//         list_for_each_entry(_node, &(_vertex->list), list) {\
-//             qpush(_Q, _node->id);\
-
-//             op((G) + _node->id);    \
-
-
-//             if ((( (G) + _node->id)->dist) == -1) {\
-//                 ( (G) + _node->id)->dist = _vertex->dist + 1;\
-//             }\
-//         }\
-//     }\
-//     free_buf(_Q);    })
-
-#endif	/*  __GRAPH_H__ */
\ No newline at end of file
+/*
+            压缩稀疏行(CSR)图
+    全部边按起点顺序存放在连续数组中, 顶点 u 的出边为 targets/weights 的
+    [offsets[u], offsets[u + 1]) 区间, 遍历邻接顶点只需顺序读内存.
+    图构建完成后不能再插入边, 需要修改时转回邻接表.
+e.g.
+csr_graph C;
+csr_from_list(&C, G, n);
+long e;
+csr_for_each_edge(&C, u, e)
+    printf("%d(%d) ", C.targets[e], C.weights[e]);
+csr_free(&C);
+ */
+typedef struct csr_graph {
+    int n;                  /* 顶点个数 */
+    long m;                 /* 边数 */
+    long *offsets;          /* n + 1 个, 顶点 u 的第一条出边下标为 offsets[u] */
+    int *targets;           /* m 个, 边的终点 */
+    int *weights;           /* m 个, 边的权 */
+} csr_graph;
+
+/**
+ * csr_init - 为 n 个顶点 m 条边的 CSR 图分配空间, offsets 清零
+ * @C:      CSR 图
+ * @n:      顶点个数
+ * @m:      边数
+ * @return: 无
+ */
+static inline void csr_init(csr_graph *C, int n, long m)
+{
+    C->n = n;
+    C->m = m;
+    C->offsets = calloc_buf(n + 1, long);
+    C->targets = (int *)malloc(max(m, 1L) * sizeof(int));
+    C->weights = (int *)malloc(max(m, 1L) * sizeof(int));
+    assert(C->targets && C->weights);
+}
+
+/* csr_free - 释放 CSR 图 */
+static inline void csr_free(csr_graph *C)
+{
+    free_buf(C->offsets);
+    free_buf(C->targets);
+    free_buf(C->weights);
+    C->n = 0;
+    C->m = 0;
+}
+
+/* csr_degree - 顶点 u 的出度 */
+#define csr_degree(C, u)    ({ (C)->offsets[(u) + 1] - (C)->offsets[(u)]; })
+
+/**
+ * csr_for_each_edge - 遍历顶点 u 的全部出边
+ * @C:      CSR 图
+ * @u:      顶点
+ * @e:      long 类型的边下标, 终点为 (C)->targets[e], 权为 (C)->weights[e]
+ */
+#define csr_for_each_edge(C, u, e)  \
+    for ((e) = (C)->offsets[(u)]; (e) < (C)->offsets[(u) + 1]; ++(e))
+
+/* __csr_prefix_sum - offsets[u + 1] 中为顶点 u 的出度, 转换为各顶点第一条出边的下标 */
+static inline void __csr_prefix_sum(csr_graph *C)
+{
+    for (int u = 0; u < C->n; ++u)
+        C->offsets[u + 1] += C->offsets[u];
+}
+
+/**
+ * csr_from_list - 邻接表转 CSR 图, 每个顶点的出边保持邻接表中的顺序
+ * @C:      保存 CSR 图(未初始化)
+ * @G:      图(邻接表)
+ * @n:      图中顶点个数
+ * @return: 无
+ */
+static inline void csr_from_list(csr_graph *C, _Vertex_ *G, int n)
+{
+    _adj_node_ *node;
+    long m = 0, e = 0;
+    int u;
+
+    for (u = 0; u < n; ++u)
+        list_for_each_entry(node, &(G + u)->list, list)
+            ++m;
+    csr_init(C, n, m);
+    for (u = 0; u < n; ++u) {
+        C->offsets[u] = e;
+        list_for_each_entry(node, &(G + u)->list, list) {
+            C->targets[e] = node->id;
+            C->weights[e++] = node->w;
+        }
+    }
+    C->offsets[n] = e;
+}
+
+/**
+ * csr_from_edges - 由边数组构建 CSR 图(按起点计数排序, 同一起点的边保持输入顺序)
+ * @C:      保存 CSR 图(未初始化)
+ * @n:      顶点个数
+ * @m:      边数
+ * @src:    m 个边的起点
+ * @dst:    m 个边的终点
+ * @w:      m 个边的权, 为 NULL 时权均为 0
+ * @return: 无
+ */
+static inline void csr_from_edges(csr_graph *C, int n, long m, const int *src, const int *dst, const int *w)
+{
+    long *next;
+    long e, pos;
+
+    csr_init(C, n, m);
+    for (e = 0; e < m; ++e)
+        ++C->offsets[src[e] + 1];
+    __csr_prefix_sum(C);
+
+    next = calloc_buf(n, long);
+    memcpy(next, C->offsets, n * sizeof(long));
+    for (e = 0; e < m; ++e) {
+        pos = next[src[e]]++;
+        C->targets[pos] = dst[e];
+        C->weights[pos] = w ? w[e] : 0;
+    }
+    free_buf(next);
+}
+
+/**
+ * csr_to_list - CSR 图转邻接表, 边节点由 calloc 分配, 使用 clear_G 释放
+ * @C:      CSR 图
+ * @G:      保存邻接表(已 init)
+ * @return: 无
+ */
+#define csr_to_list(C, G) ({    \
+    long __e;                   \
+    for (int __u = 0; __u < (C)->n; ++__u)     \
+        csr_for_each_edge( (C), __u, __e )      \
+            insert( (G), __u, (C)->targets[__e], (C)->weights[__e] );  \
+})
+
+/**
+ * csr_to_list_pool - CSR 图转邻接表, 边节点从对象池中分配, 使用 clear_G_pool 释放
+ * @C:      CSR 图
+ * @G:      保存邻接表(已 init)
+ * @P:      _adj_node_ 类型的对象池
+ * @return: 无
+ */
+#define csr_to_list_pool(C, G, P) ({    \
+    long __e;                           \
+    for (int __u = 0; __u < (C)->n; ++__u)     \
+        csr_for_each_edge( (C), __u, __e )      \
+            insert_pool( (G), __u, (C)->targets[__e], (C)->weights[__e], (P) );  \
+})
+
+static inline void __csr_from_matrix(csr_graph *C, const int *matrix, int n)
+{
+    long m = 0, e = 0;
+    int i, j;
+
+    for (i = 0; i < n; ++i)
+        for (j = 0; j < n; ++j)
+            m += i != j && matrix[(long)i * n + j] != WEIGHT_INFTY;
+    csr_init(C, n, m);
+    for (i = 0; i < n; ++i) {
+        C->offsets[i] = e;
+        for (j = 0; j < n; ++j)
+            if (i != j && matrix[(long)i * n + j] != WEIGHT_INFTY) {
+                C->targets[e] = j;
+                C->weights[e++] = matrix[(long)i * n + j];
+            }
+    }
+    C->offsets[n] = e;
+}
+
+/**
+ * csr_from_matrix - 邻接矩阵转 CSR 图
+ *      Note:
+ *          对角线为 list2matrix 填入的 0, 不作为自环插入, 因此 list2matrix 与
+ *          csr_from_matrix 往返后与原邻接表的边相同(原图中没有自环时)
+ * @C:      保存 CSR 图(未初始化)
+ * @matrix: 邻接矩阵(int **, 实际为连续的 n * n 个 int)
+ * @n:      图中顶点个数
+ * @return: 无
+ */
+#define csr_from_matrix(C, matrix, n)   ({ __csr_from_matrix( (C), (const int *)(matrix), (n) ); })
+
+static inline void __csr_to_matrix(const csr_graph *C, int *matrix)
+{
+    long n = C->n, e;
+    int u;
+
+    for (u = 0; u < n; ++u)
+        for (long j = 0; j < n; ++j)
+            matrix[u * n + j] = u == j ? 0 : WEIGHT_INFTY;
+    for (u = 0; u < n; ++u)
+        csr_for_each_edge(C, u, e)
+            matrix[u * n + C->targets[e]] = C->weights[e];
+}
+
+/**
+ * csr_to_matrix - CSR 图转邻接矩阵, 与 list2matrix 相同, 没有边的位置为 WEIGHT_INFTY, 对角线为 0
+ * @C:      CSR 图
+ * @matrix: 保存转换后的邻接矩阵(int **, 实际为连续的 n * n 个 int)
+ * @return: 无
+ */
+#define csr_to_matrix(C, matrix)    ({ __csr_to_matrix( (C), (int *)(matrix) ); })
+
+/**
+ * show_csr - 显示 CSR 图, 格式与 show_adj_list 相同
+ * @C:          CSR 图
+ * @return:     无
+ */
+#define show_csr(C) ({      \
+    long __e;               \
+    for (int __u = 0; __u < (C)->n; ++__u) {  \
+        printf("%d -> ", __u);  \
+        csr_for_each_edge( (C), __u, __e )    \
+            printf("%d(%d) ", (C)->targets[__e], (C)->weights[__e]);   \
+        printf("\n");   \
+    }   \
+})
+
+
+/*
+            BFS / DFS
+    搜索结果与缓冲区保存在 graph_search 中, 初始化后可对同一个图反复搜索,
+    每次搜索只重置上一次访问过的顶点, 不再分配内存.
+e.g.
+graph_search S;
+graph_search_init(&S, n);
+bfs(G, &S, s);
+for (int i = 0; i < S.count; ++i)
+    printf("%d: dist %d, parent %d\n", S.order[i], S.dist[S.order[i]], S.parent[S.order[i]]);
+graph_search_free(&S);
+ */
+typedef struct graph_search {
+    int n;                  /* 顶点个数 */
+    int count;              /* 本次搜索访问的顶点个数 */
+    int *dist;              /* 到起点的边数(DFS 中为搜索树深度), 未访问为 -1 */
+    int *parent;            /* 搜索树中的父顶点, 起点与未访问顶点为 -1 */
+    int *order;             /* 顶点的发现顺序, 前 count 个有效 */
+    int *frontier;          /* BFS 队列 / DFS 栈 */
+    struct list_head **next;    /* DFS 中栈内顶点下一条待检查的边 */
+} graph_search;
+
+/**
+ * graph_search_init - 为 n 个顶点的图分配搜索缓冲区
+ * @S:      搜索结果
+ * @n:      图中顶点个数
+ * @return: 无
+ */
+static inline void graph_search_init(graph_search *S, int n)
+{
+    S->n = n;
+    S->count = 0;
+    S->dist = calloc_buf(n, int);
+    S->parent = calloc_buf(n, int);
+    S->order = calloc_buf(n, int);
+    S->frontier = calloc_buf(n, int);
+    S->next = calloc_buf(n, struct list_head *);
+    memset(S->dist, -1, n * sizeof(int));
+    memset(S->parent, -1, n * sizeof(int));
+}
+
+/* graph_search_free - 释放搜索缓冲区 */
+static inline void graph_search_free(graph_search *S)
+{
+    free_buf(S->dist);
+    free_buf(S->parent);
+    free_buf(S->order);
+    free_buf(S->frontier);
+    free_buf(S->next);
+    S->n = S->count = 0;
+}
+
+/* __graph_search_reset - 只重置上一次搜索访问过的顶点 */
+static inline void __graph_search_reset(graph_search *S)
+{
+    for (int i = 0; i < S->count; ++i)
+        S->dist[S->order[i]] = S->parent[S->order[i]] = -1;
+    S->count = 0;
+}
+
+/* __graph_search_visit - 发现顶点 v */
+static inline void __graph_search_visit(graph_search *S, int v, int parent, int dist)
+{
+    S->dist[v] = dist;
+    S->parent[v] = parent;
+    S->order[S->count++] = v;
+}
+
+/**
+ * bfs - 广度优先搜索, 得到从 s 出发到各顶点的最短距离(边数)
+ * @G:      图(邻接表)
+ * @S:      搜索结果(已 graph_search_init)
+ * @s:      起点
+ * @return: 访问的顶点个数
+ */
+static inline int bfs(_Vertex_ *G, graph_search *S, int s)
+{
+    _adj_node_ *node;
+    int head = 0, tail = 0, u;
+
+    __graph_search_reset(S);
+    __graph_search_visit(S, s, -1, 0);
+    S->frontier[tail++] = s;
+    while (head < tail) {
+        u = S->frontier[head++];
+        list_for_each_entry(node, &(G + u)->list, list)
+            if (S->dist[node->id] == -1) {
+                __graph_search_visit(S, node->id, u, S->dist[u] + 1);
+                S->frontier[tail++] = node->id;
+            }
+    }
+    return S->count;
+}
+
+/**
+ * dfs - 深度优先搜索(迭代实现, 不受递归深度限制), 邻接顶点按邻接表顺序访问
+ * @G:      图(邻接表)
+ * @S:      搜索结果(已 graph_search_init), order 为先序, dist 为搜索树深度
+ * @s:      起点
+ * @return: 访问的顶点个数
+ */
+static inline int dfs(_Vertex_ *G, graph_search *S, int s)
+{
+    _adj_node_ *node;
+    int top = 0, u;
+
+    __graph_search_reset(S);
+    __graph_search_visit(S, s, -1, 0);
+    S->frontier[top++] = s;
+    S->next[s] = (G + s)->list.next;
+    while (top > 0) {
+        u = S->frontier[top - 1];
+        if (S->next[u] == &(G + u)->list) {
+            --top;
+            continue;
+        }
+        node = list_entry(S->next[u], _adj_node_, list);
+        S->next[u] = S->next[u]->next;
+        if (S->dist[node->id] == -1) {
+            __graph_search_visit(S, node->id, u, S->dist[u] + 1);
+            S->frontier[top++] = node->id;
+            S->next[node->id] = (G + node->id)->list.next;
+        }
+    }
+    return S->count;
+}
+
+/**
+ * graph_path - 由搜索结果得到从起点到 t 的路径
+ * @S:      搜索结果
+ * @t:      终点
+ * @path:   保存路径(起点在前), 长度至少为 dist[t] + 1
+ * @return: 路径上的顶点个数, t 不可达返回 0
+ */
+static inline int graph_path(const graph_search *S, int t, int *path)
+{
+    int len, i;
+
+    if (S->dist[t] == -1)
+        return 0;
+    len = S->dist[t] + 1;
+    for (i = len - 1; i >= 0; --i, t = S->parent[t])
+        path[i] = t;
+    return len;
+}
+
+/**
+ * csr_transpose - 求 CSR 图的转置(全部边反向), 用于有向图的自底向上 BFS
+ * @C:      CSR 图
+ * @T:      保存转置图(未初始化)
+ * @return: 无
+ */
+static inline void csr_transpose(const csr_graph *C, csr_graph *T)
+{
+    long *next;
+    long e, pos;
+    int u;
+
+    csr_init(T, C->n, C->m);
+    for (e = 0; e < C->m; ++e)
+        ++T->offsets[C->targets[e] + 1];
+    __csr_prefix_sum(T);
+
+    next = calloc_buf(C->n, long);
+    memcpy(next, T->offsets, C->n * sizeof(long));
+    for (u = 0; u < C->n; ++u)
+        csr_for_each_edge(C, u, e) {
+            pos = next[C->targets[e]]++;
+            T->targets[pos] = u;
+            T->weights[pos] = C->weights[e];
+        }
+    free_buf(next);
+}
+
+/*
+            方向优化并行 BFS(Beamer)
+    每一层选择一种方向:
+        自顶向下: 遍历当前层全部顶点的出边, 以 CAS 抢占未访问的邻接顶点, 当前层保存为队列
+        自底向上: 遍历全部未访问顶点的入边, 找到一个位于当前层的父顶点即停止, 当前层保存为位图
+    当前层出边数 mf > 未访问顶点的边数 mu / alpha 时切换为自底向上,
+    自底向上时当前层顶点数 nf < n / beta 时切换回自顶向下.
+    低直径图(社交网络, R-MAT)的中间几层包含大部分顶点, 自底向上可以跳过其中绝大多数边的检查.
+    结果与 graph_search 相同, 写入 dist/parent(同一层内父顶点不唯一).
+e.g.
+csr_search B;
+csr_search_init(&B, C.n, 4);
+csr_bfs(&C, &C, &B, s);         无向图的入边即出边, 有向图传入 csr_transpose 得到的转置图
+csr_search_free(&B);
+ */
+typedef struct csr_search {
+    int n;                  /* 顶点个数 */
+    int nthreads;           /* 线程数(含调用线程) */
+    int alpha, beta;        /* 方向切换参数, alpha <= 0 时只使用自顶向下 */
+    long count;             /* 本次搜索访问的顶点个数 */
+    int levels;             /* 本次搜索的层数 */
+    int bottom_up_levels;   /* 其中自底向上的层数 */
+    int *dist;              /* 到起点的边数, 未访问为 -1 */
+    int *parent;            /* BFS 树中的父顶点, 起点与未访问顶点为 -1 */
+    int *queue, *next_queue;            /* 自顶向下的当前层/下一层 */
+    unsigned long *front, *next_front;  /* 自底向上的当前层/下一层位图 */
+} csr_search;
+
+#define __CSR_BFS_WORD          (sizeof(unsigned long) * 8)
+#define __CSR_BFS_WORDS(n)      (((n) + __CSR_BFS_WORD - 1) / __CSR_BFS_WORD)
+#define __CSR_BFS_CHUNK         256     /* 自顶向下每次领取的顶点数, 也是线程本地缓冲区大小 */
+#define __CSR_BFS_WORD_CHUNK    16      /* 自底向上每次领取的位图字数 */
+
+/**
+ * csr_search_init - 为 n 个顶点的图分配搜索缓冲区
+ * @B:          搜索结果
+ * @n:          图中顶点个数
+ * @nthreads:   线程数
+ * @return:     无
+ */
+static inline void csr_search_init(csr_search *B, int n, int nthreads)
+{
+    B->n = n;
+    B->nthreads = max(nthreads, 1);
+    B->alpha = 14;
+    B->beta = 24;
+    B->count = B->levels = B->bottom_up_levels = 0;
+    B->dist = calloc_buf(n, int);
+    B->parent = calloc_buf(n, int);
+    B->queue = calloc_buf(n, int);
+    B->next_queue = calloc_buf(n, int);
+    B->front = calloc_buf(__CSR_BFS_WORDS(n), unsigned long);
+    B->next_front = calloc_buf(__CSR_BFS_WORDS(n), unsigned long);
+}
+
+/* csr_search_free - 释放搜索缓冲区 */
+static inline void csr_search_free(csr_search *B)
+{
+    free_buf(B->dist);
+    free_buf(B->parent);
+    free_buf(B->queue);
+    free_buf(B->next_queue);
+    free_buf(B->front);
+    free_buf(B->next_front);
+}
+
+/*
+ * 一次搜索中全部线程共享的状态, 每层结束时由 0 号线程在两次 barrier 之间更新
+ * @head:       当前层中下一个待领取的位置(顶点或位图字)
+ * @tail:       下一层队列长度
+ * @nf, mf:     下一层顶点数, 出边数
+ * @mu:         未访问顶点的边数
+ * @cur:        当前层队列长度
+ */
+struct __csr_bfs_team {
+    const csr_graph *C, *T;
+    csr_search *B;
+    pthread_barrier_t barrier;
+    long head __cacheline_aligned;
+    long tail __cacheline_aligned;
+    long nf __cacheline_aligned;
+    long mf;
+    long mu, cur;
+    int level;
+    bool bottom_up, done;
+};
+
+struct __csr_bfs_arg {
+    struct __csr_bfs_team *team;
+    int id;
+};
+
+/* __csr_bfs_flush - 将线程本地缓冲区中的顶点加入下一层队列 */
+static inline void __csr_bfs_flush(struct __csr_bfs_team *t, int *buf, int len)
+{
+    long pos = __atomic_fetch_add(&t->tail, len, __ATOMIC_RELAXED);
+    memcpy(t->B->next_queue + pos, buf, len * sizeof(int));
+}
+
+/* __csr_bfs_top_down - 自顶向下处理一层, 返回 (下一层顶点数, 出边数) 累加到 team */
+static inline void __csr_bfs_top_down(struct __csr_bfs_team *t)
+{
+    const csr_graph *C = t->C;
+    csr_search *B = t->B;
+    int buf[__CSR_BFS_CHUNK], len = 0, u, v, unvisited;
+    long i, end, e, nf = 0, mf = 0;
+
+    while ((i = __atomic_fetch_add(&t->head, __CSR_BFS_CHUNK, __ATOMIC_RELAXED)) < t->cur) {
+        end = min(i + __CSR_BFS_CHUNK, t->cur);
+        for (; i < end; ++i) {
+            u = B->queue[i];
+            csr_for_each_edge(C, u, e) {
+                v = C->targets[e];
+                unvisited = -1;
+                if (__atomic_load_n(&B->dist[v], __ATOMIC_RELAXED) != -1
+                        || !__atomic_compare_exchange_n(&B->dist[v], &unvisited, t->level + 1, false,
+                                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                    continue;
+                B->parent[v] = u;
+                mf += csr_degree(C, v);
+                buf[len++] = v;
+                if (len == __CSR_BFS_CHUNK) {
+                    __csr_bfs_flush(t, buf, len);
+                    nf += len;
+                    len = 0;
+                }
+            }
+        }
+    }
+    if (len)
+        __csr_bfs_flush(t, buf, len);
+    __atomic_add_fetch(&t->nf, nf + len, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&t->mf, mf, __ATOMIC_RELAXED);
+}
+
+/* __csr_bfs_bottom_up - 自底向上处理一层, 每个位图字只由领取它的线程写入, 不需要原子操作 */
+static inline void __csr_bfs_bottom_up(struct __csr_bfs_team *t)
+{
+    const csr_graph *C = t->C, *T = t->T;
+    csr_search *B = t->B;
+    long words = __CSR_BFS_WORDS(B->n), w, end, e, nf = 0, mf = 0;
+    unsigned long bits;
+    int v, vend, u;
+
+    while ((w = __atomic_fetch_add(&t->head, __CSR_BFS_WORD_CHUNK, __ATOMIC_RELAXED)) < words) {
+        end = min(w + __CSR_BFS_WORD_CHUNK, words);
+        for (; w < end; ++w) {
+            bits = 0;
+            vend = min((w + 1) * (long)__CSR_BFS_WORD, (long)B->n);
+            for (v = w * __CSR_BFS_WORD; v < vend; ++v) {
+                if (B->dist[v] != -1)
+                    continue;
+                csr_for_each_edge(T, v, e) {
+                    u = T->targets[e];
+                    if (B->front[u / __CSR_BFS_WORD] & (1UL << (u % __CSR_BFS_WORD))) {
+                        B->dist[v] = t->level + 1;
+                        B->parent[v] = u;
+                        bits |= 1UL << (v % __CSR_BFS_WORD);
+                        ++nf;
+                        mf += csr_degree(C, v);
+                        break;
+                    }
+                }
+            }
+            B->next_front[w] = bits;
+        }
+    }
+    __atomic_add_fetch(&t->nf, nf, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&t->mf, mf, __ATOMIC_RELAXED);
+}
+
+/* __csr_bfs_next_level - 0 号线程统计一层的结果, 选择下一层的方向并转换当前层的表示 */
+static inline void __csr_bfs_next_level(struct __csr_bfs_team *t)
+{
+    csr_search *B = t->B;
+    long words = __CSR_BFS_WORDS(B->n), i, w;
+    unsigned long bits;
+    int v;
+
+    B->count += t->nf;
+    B->bottom_up_levels += t->bottom_up;
+    t->mu -= t->mf;
+    t->level++;
+    if (t->nf == 0) {
+        t->done = true;
+        return;
+    }
+
+    if (!t->bottom_up) {
+        if (B->alpha > 0 && t->mf > t->mu / B->alpha) {
+            /* 队列 -> 位图 */
+            memset(B->front, 0, words * sizeof(unsigned long));
+            for (i = 0; i < t->nf; ++i) {
+                v = B->next_queue[i];
+                B->front[v / __CSR_BFS_WORD] |= 1UL << (v % __CSR_BFS_WORD);
+            }
+            t->bottom_up = true;
+        } else {
+            swap(&B->queue, &B->next_queue);
+            t->cur = t->nf;
+        }
+    } else if (t->nf < B->n / B->beta) {
+        /* 位图 -> 队列 */
+        for (i = 0, w = 0; w < words; ++w)
+            for (bits = B->next_front[w]; bits; bits &= bits - 1)
+                B->queue[i++] = w * __CSR_BFS_WORD + __builtin_ctzl(bits);
+        t->cur = t->nf;
+        t->bottom_up = false;
+    } else
+        swap(&B->front, &B->next_front);
+
+    t->head = t->tail = 0;
+    t->nf = t->mf = 0;
+}
+
+static inline void *__csr_bfs_worker(void *arg)
+{
+    struct __csr_bfs_team *t = ((struct __csr_bfs_arg *)arg)->team;
+    int id = ((struct __csr_bfs_arg *)arg)->id;
+    csr_search *B = t->B;
+    long lo = (long)B->n * id / B->nthreads, hi = (long)B->n * (id + 1) / B->nthreads;
+
+    /* 各线程重置自己负责的区间, 全部重置完成后再设置起点 */
+    memset(B->dist + lo, -1, (hi - lo) * sizeof(int));
+    memset(B->parent + lo, -1, (hi - lo) * sizeof(int));
+    if (pthread_barrier_wait(&t->barrier) == PTHREAD_BARRIER_SERIAL_THREAD)
+        B->dist[B->queue[0]] = 0;
+    pthread_barrier_wait(&t->barrier);
+
+    while (!t->done) {
+        if (t->bottom_up)
+            __csr_bfs_bottom_up(t);
+        else
+            __csr_bfs_top_down(t);
+        pthread_barrier_wait(&t->barrier);
+        if (id == 0)
+            __csr_bfs_next_level(t);
+        pthread_barrier_wait(&t->barrier);
+    }
+    return NULL;
+}
+
+/**
+ * csr_bfs - 方向优化并行 BFS
+ * @C:      CSR 图
+ * @T:      C 的转置图(用于自底向上查找入边), 无向图(每条边双向插入)直接传入 C
+ * @B:      搜索结果(已 csr_search_init)
+ * @s:      起点
+ * @return: 访问的顶点个数
+ */
+static inline long csr_bfs(const csr_graph *C, const csr_graph *T, csr_search *B, int s)
+{
+    struct __csr_bfs_team team = { .C = C, .T = T, .B = B };
+    struct __csr_bfs_arg *args = calloc_buf(B->nthreads, struct __csr_bfs_arg);
+    pthread_t *threads = calloc_buf(B->nthreads, pthread_t);
+    int i;
+
+    assert(C->n == B->n && T->n == B->n);
+    B->count = 1;
+    B->levels = B->bottom_up_levels = 0;
+    B->queue[0] = s;
+    team.cur = 1;
+    team.mu = C->m - csr_degree(C, s);
+    pthread_barrier_init(&team.barrier, NULL, B->nthreads);
+    for (i = 0; i < B->nthreads; ++i) {
+        args[i].team = &team;
+        args[i].id = i;
+        if (i)
+            pthread_create(threads + i, NULL, __csr_bfs_worker, args + i);
+    }
+    __csr_bfs_worker(args);
+    for (i = 1; i < B->nthreads; ++i)
+        pthread_join(threads[i], NULL);
+
+    pthread_barrier_destroy(&team.barrier);
+    free_buf(args);
+    free_buf(threads);
+    B->levels = team.level;
+    return B->count;
+}
+
+#endif	/*  __GRAPH_H__ */
@@ -0,0 +1,340 @@
+/***************************************************************
+Copyright © wkangk <wangkangchn@163.com>
+文件名		: graph_bench.c
+作者	  	: wkangk <wangkangchn@163.com>
+版本	   	: v1.0
+描述	   	: R-MAT 随机图(Graph500 参数)上的 BFS 性能测试, 输出每秒遍历边数(TEPS)
+            自顶向下与方向优化 BFS 在不同线程数下的对比;
+            同一 R-MAT 图(随机边权)上 dijkstra_batch 与逐次查询(每次分配缓冲区)的对比,
+            网格图上 dijkstra_pairs, astar 与逐次查询的对比;
+            随机稠密图上三重循环与分块 Floyd–Warshall 的对比
+            用法: ./app_graph_bench [scale] [最大线程数] [Floyd 顶点数],
+            顶点数为 2^scale, 边数为 16 * 2^scale
+时间	   	: 2026-10-19 04:30
+***************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+#include "tools.h"
+#include "graph.h"
+#include "shortest_path.h"
+
+#define EDGE_FACTOR     16
+#define NSOURCES        16
+#define NPAIRS          1024
+
+/* R-MAT 各象限概率 a, b, c, d = 1 - a - b - c */
+#define RMAT_A          0.57
+#define RMAT_B          0.19
+#define RMAT_C          0.19
+
+static unsigned long long seed = 88172645463325252ULL;
+
+/* xorshift64, 返回 [0, 1) 的随机数 */
+static double rand01(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return (seed >> 11) * (1.0 / (1ULL << 53));
+}
+
+/* 墙上时间(秒), clock() 统计的是所有线程的 CPU 时间 */
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * rmat - 生成 R-MAT 无向图, 每条边双向插入, 顶点编号随机置换以打乱局部性
+ * @C:      保存 CSR 图
+ * @scale:  顶点数为 2^scale
+ */
+static void rmat(csr_graph *C, int scale)
+{
+    int n = 1 << scale, i, j, u, v, bit;
+    long m = (long)EDGE_FACTOR * n, e;
+    int *src = calloc_buf(2 * m, int);
+    int *dst = calloc_buf(2 * m, int);
+    int *perm = calloc_buf(n, int);
+    double r;
+
+    for (i = 0; i < n; ++i)
+        perm[i] = i;
+    for (i = n - 1; i > 0; --i) {
+        j = rand01() * (i + 1);
+        swap(perm + i, perm + j);
+    }
+
+    for (e = 0; e < m; ++e) {
+        u = v = 0;
+        for (bit = 0; bit < scale; ++bit) {
+            r = rand01();
+            if (r < RMAT_A)
+                ;
+            else if (r < RMAT_A + RMAT_B)
+                v |= 1 << bit;
+            else if (r < RMAT_A + RMAT_B + RMAT_C)
+                u |= 1 << bit;
+            else {
+                u |= 1 << bit;
+                v |= 1 << bit;
+            }
+        }
+        src[2 * e] = dst[2 * e + 1] = perm[u];
+        dst[2 * e] = src[2 * e + 1] = perm[v];
+    }
+    csr_from_edges(C, n, 2 * m, src, dst, NULL);
+
+    free_buf(src);
+    free_buf(dst);
+    free_buf(perm);
+}
+
+/**
+ * bench_dijkstra - 多源最短路径, dijkstra_batch 复用同一个 sp_search, 逐次查询每次重新分配并初始化
+ * @C:          边权为正的图
+ * @sources:    NSOURCES 个起点
+ */
+static void bench_dijkstra(const csr_graph *C, const int *sources)
+{
+    long *ref = calloc_buf((long)NSOURCES * C->n, long);
+    long *dist = calloc_buf((long)NSOURCES * C->n, long);
+    sp_search S;
+    double start;
+
+    start = now();
+    for (int i = 0; i < NSOURCES; ++i) {
+        sp_search_init(&S, C->n);
+        csr_dijkstra(C, &S, sources[i]);
+        memcpy(ref + (long)i * C->n, S.dist, C->n * sizeof(long));
+        sp_search_free(&S);
+    }
+    printf("dijkstra %d 个起点: 逐次查询 %.3f 秒\n", NSOURCES, now() - start);
+
+    start = now();
+    sp_search_init(&S, C->n);
+    csr_dijkstra_batch(C, &S, sources, NSOURCES, dist);
+    sp_search_free(&S);
+    printf("dijkstra %d 个起点: dijkstra_batch %.3f 秒%s\n", NSOURCES, now() - start,
+            memcmp(dist, ref, (long)NSOURCES * C->n * sizeof(long)) ? " (距离错误!)" : "");
+
+    free_buf(ref);
+    free_buf(dist);
+}
+
+/* 网格图中顶点 v 到 t 的曼哈顿距离, 边权至少为 1, 不会高估 */
+static long grid_manhattan(int v, int t, void *arg)
+{
+    int cols = *(int *)arg;
+    return labs(v / cols - t / cols) + labs(v % cols - t % cols);
+}
+
+/**
+ * bench_grid_pairs - side * side 网格图(类似路网, 直径大)上 NPAIRS 个局部点到点查询,
+ *      每次查询只访问起点附近的顶点, 逐次查询时 O(n) 的分配与初始化占主要时间
+ * @side:   网格边长
+ */
+static void bench_grid_pairs(int side)
+{
+    int n = side * side, r, c, k, i, m = 0;
+    int dr[] = {0, 1, 0, -1}, dc[] = {1, 0, -1, 0};
+    int *src = calloc_buf(4L * n, int), *dst = calloc_buf(4L * n, int), *w = calloc_buf(4L * n, int);
+    int qs[NPAIRS], qt[NPAIRS];
+    long ref[NPAIRS], dist[NPAIRS];
+    csr_graph C;
+    sp_search S;
+    double start;
+    bool ok = true;
+
+    for (r = 0; r < side; ++r)
+        for (c = 0; c < side; ++c)
+            for (k = 0; k < 4; ++k)
+                if (r + dr[k] >= 0 && r + dr[k] < side && c + dc[k] >= 0 && c + dc[k] < side) {
+                    src[m] = r * side + c;
+                    dst[m] = (r + dr[k]) * side + c + dc[k];
+                    w[m++] = 1 + (int)(rand01() * 10);
+                }
+    csr_from_edges(&C, n, m, src, dst, w);
+
+    /* 终点在起点附近 16 * 16 的范围内 */
+    for (i = 0; i < NPAIRS; ++i) {
+        r = rand01() * (side - 16);
+        c = rand01() * (side - 16);
+        qs[i] = r * side + c;
+        qt[i] = (r + (int)(rand01() * 16)) * side + c + (int)(rand01() * 16);
+    }
+
+    start = now();
+    for (i = 0; i < NPAIRS; ++i) {
+        sp_search_init(&S, n);
+        ref[i] = csr_dijkstra_to(&C, &S, qs[i], qt[i]);
+        sp_search_free(&S);
+    }
+    printf("网格 %d * %d, %d 个局部点到点查询: 逐次查询 %.3f 秒\n", side, side, NPAIRS, now() - start);
+
+    sp_search_init(&S, n);
+    start = now();
+    csr_dijkstra_pairs(&C, &S, qs, qt, NPAIRS, dist);
+    printf("网格 %d * %d, %d 个局部点到点查询: dijkstra_pairs %.3f 秒%s\n", side, side, NPAIRS,
+            now() - start, memcmp(dist, ref, sizeof(ref)) ? " (距离错误!)" : "");
+
+    start = now();
+    for (i = 0; i < NPAIRS; ++i)
+        ok = ok && csr_astar(&C, &S, qs[i], qt[i], grid_manhattan, &side) == ref[i];
+    printf("网格 %d * %d, %d 个局部点到点查询: astar(复用缓冲区) %.3f 秒%s\n", side, side, NPAIRS,
+            now() - start, ok ? "" : " (距离错误!)");
+    sp_search_free(&S);
+
+    csr_free(&C);
+    free_buf(src);
+    free_buf(dst);
+    free_buf(w);
+}
+
+/* floyd_naive - 未分块的 Floyd–Warshall, 作为参考结果 */
+static void floyd_naive(int *d, long n)
+{
+    int t;
+
+    for (long k = 0; k < n; ++k)
+        for (long i = 0; i < n; ++i)
+            for (long j = 0; j < n; ++j) {
+                t = d[i * n + k] + d[k * n + j];
+                if (t < d[i * n + j])
+                    d[i * n + j] = t;
+            }
+}
+
+/**
+ * bench_floyd - n 个顶点, 每对顶点之间有 30% 的概率有边的随机图上的全源最短路径
+ * @n:              顶点个数
+ * @max_threads:    最大线程数
+ */
+static void bench_floyd(int n, int max_threads)
+{
+    long size = (long)n * n;
+    int *matrix = calloc_buf(size, int);
+    int *ref = calloc_buf(size, int);
+    int *d = calloc_buf(size, int);
+    double start;
+
+    for (long i = 0; i < size; ++i)
+        matrix[i] = rand01() < 0.3 ? 1 + (int)(rand01() * 1000) : WEIGHT_INFTY;
+    for (long i = 0; i < n; ++i)
+        matrix[i * n + i] = 0;
+
+    memcpy(ref, matrix, size * sizeof(int));
+    start = now();
+    floyd_naive(ref, n);
+    printf("Floyd %d 个顶点: 三重循环 %.3f 秒\n", n, now() - start);
+
+    for (int nthreads = 1; nthreads <= max_threads; nthreads <<= 1) {
+        memcpy(d, matrix, size * sizeof(int));
+        start = now();
+        floyd_warshall((int **)d, n, nthreads);
+        printf("Floyd %d 个顶点: 分块 %2d 线程 %.3f 秒%s\n", n, nthreads, now() - start,
+                memcmp(d, ref, size * sizeof(int)) ? " (距离错误!)" : "");
+    }
+
+    free_buf(matrix);
+    free_buf(ref);
+    free_buf(d);
+}
+
+/* component_edges - 本次搜索访问到的连通分量中的(无向)边数 */
+static long component_edges(const csr_graph *C, const csr_search *B)
+{
+    long edges = 0;
+
+    for (int v = 0; v < C->n; ++v)
+        if (B->dist[v] != -1)
+            edges += csr_degree(C, v);
+    return edges / 2;
+}
+
+/**
+ * bench - 从 sources 中的每个起点执行一次 BFS, 输出平均 TEPS, 并与参考结果 ref 比较距离
+ * @name:       测试名称
+ * @C:          图
+ * @B:          搜索缓冲区(已设置线程数与方向参数)
+ * @sources:    起点
+ * @ref:        NSOURCES * n 个参考距离, 为 NULL 时保存本次结果
+ */
+static void bench(const char *name, const csr_graph *C, csr_search *B, const int *sources, int *ref)
+{
+    double start, elapsed, total = 0, edges = 0;
+    int bottom_up = 0, levels = 0;
+    bool ok = true;
+
+    for (int i = 0; i < NSOURCES; ++i) {
+        start = now();
+        csr_bfs(C, C, B, sources[i]);
+        elapsed = now() - start;
+        total += elapsed;
+        edges += component_edges(C, B);
+        levels += B->levels;
+        bottom_up += B->bottom_up_levels;
+        if (memcmp(ref + (long)i * C->n, B->dist, C->n * sizeof(int)))
+            ok = false;
+    }
+    printf("%-22s %2d 线程 %8.2f M TEPS, 平均 %.1f 层(自底向上 %.1f 层)%s\n", name, B->nthreads,
+            edges / total / 1e6, (double)levels / NSOURCES, (double)bottom_up / NSOURCES,
+            ok ? "" : " (距离错误!)");
+}
+
+int main(int argc, char *argv[])
+{
+    int scale = argc > 1 ? atoi(argv[1]) : 18;
+    int max_threads = argc > 2 ? atoi(argv[2]) : 4;
+    int floyd_n = argc > 3 ? atoi(argv[3]) : 1000;
+    int sources[NSOURCES], *ref, i, nthreads;
+    csr_graph C;
+    csr_search B;
+    double start;
+
+    start = now();
+    rmat(&C, scale);
+    printf("R-MAT scale %d: %d 个顶点, %ld 条有向边, 生成用时 %.2f 秒\n", scale, C.n, C.m, now() - start);
+
+    /* 起点为度数不为 0 的随机顶点 */
+    for (i = 0; i < NSOURCES; ) {
+        sources[i] = rand01() * C.n;
+        if (csr_degree(&C, sources[i]) > 0)
+            ++i;
+    }
+
+    /* 参考结果: 单线程自顶向下 */
+    ref = calloc_buf((long)NSOURCES * C.n, int);
+    csr_search_init(&B, C.n, 1);
+    B.alpha = 0;
+    for (i = 0; i < NSOURCES; ++i) {
+        csr_bfs(&C, &C, &B, sources[i]);
+        memcpy(ref + (long)i * C.n, B.dist, C.n * sizeof(int));
+    }
+    csr_search_free(&B);
+
+    for (nthreads = 1; nthreads <= max_threads; nthreads <<= 1) {
+        csr_search_init(&B, C.n, nthreads);
+        B.alpha = 0;
+        bench("自顶向下", &C, &B, sources, ref);
+        B.alpha = 14;
+        bench("方向优化", &C, &B, sources, ref);
+        csr_search_free(&B);
+    }
+
+    /* BFS 不使用边权, 之后随机设置边权测试 Dijkstra */
+    for (long e = 0; e < C.m; ++e)
+        C.weights[e] = 1 + (int)(rand01() * 100);
+    bench_dijkstra(&C, sources);
+    bench_grid_pairs(1024);
+
+    csr_free(&C);
+    free_buf(ref);
+
+    bench_floyd(floyd_n, max_threads);
+    return 0;
+}
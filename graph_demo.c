@@ -12,6 +12,7 @@ Copyright © wkangk <wangkangchn@163.com>
 #include "list.h"
 #include "log.h"
 #include "graph.h"
+#include "shortest_path.h"
 
 const int MAX = 100;
 
@@ -27,6 +28,80 @@ const int MAX = 100;
 
  */
 
+/* 网格图: ROWS * COLS 个格子, 相邻格子之间有双向边, 权为 1 ~ 5, WALL 中的格子不连边 */
+#define ROWS    6
+#define COLS    8
+#define WALL(r, c)  ( (c) == 4 && (r) < 5 )
+
+/* 曼哈顿距离, 每条边的权至少为 1, 不会高估 */
+static long manhattan(int v, int t, void *arg)
+{
+    return labs(v / COLS - t / COLS) + labs(v % COLS - t % COLS);
+}
+
+/* 比较 dijkstra, csr_dijkstra, astar 与 floyd_warshall 的结果, 返回不一致的个数 */
+static int shortest_path_demo(void)
+{
+    const int n = ROWS * COLS;
+    int dr[] = {0, 1, 0, -1}, dc[] = {1, 0, -1, 0};
+    int r, c, k, u, v, t, len, bad = 0;
+    int path[ROWS * COLS];
+    long d, expect;
+    _Vertex_ *G = calloc_buf(n, _Vertex_);
+    int *matrix = calloc_buf(n * n, int);
+    csr_graph C;
+    sp_search S;
+
+    init(G, n);
+    for (r = 0; r < ROWS; ++r)
+        for (c = 0; c < COLS; ++c)
+            for (k = 0; k < 4; ++k) {
+                if (r + dr[k] < 0 || r + dr[k] >= ROWS || c + dc[k] < 0 || c + dc[k] >= COLS
+                        || WALL(r, c) || WALL(r + dr[k], c + dc[k]))
+                    continue;
+                insert(G, r * COLS + c, (r + dr[k]) * COLS + c + dc[k], 1 + (r * 7 + c * 3 + k) % 5);
+            }
+    csr_from_list(&C, G, n);
+    list2matrix(G, n, (int **)matrix);
+    floyd_warshall((int **)matrix, n, 2);
+
+    sp_search_init(&S, n);
+    for (u = 0; u < n; ++u) {
+        dijkstra(G, &S, u);
+        for (v = 0; v < n; ++v) {
+            expect = matrix[u * n + v] == WEIGHT_INFTY ? SP_INFTY : matrix[u * n + v];
+            bad += S.dist[v] != expect;
+        }
+        csr_dijkstra(&C, &S, u);
+        for (v = 0; v < n; ++v) {
+            expect = matrix[u * n + v] == WEIGHT_INFTY ? SP_INFTY : matrix[u * n + v];
+            bad += S.dist[v] != expect;
+        }
+        for (v = 0; v < n; ++v) {
+            expect = matrix[u * n + v] == WEIGHT_INFTY ? SP_INFTY : matrix[u * n + v];
+            bad += astar(G, &S, u, v, manhattan, NULL) != expect;
+            bad += csr_astar(&C, &S, u, v, manhattan, NULL) != expect;
+        }
+    }
+    printf("dijkstra/csr_dijkstra/astar 与 floyd_warshall 比较: %s\n", bad ? "不一致!" : "一致");
+
+    /* 绕过墙的路径 */
+    t = COLS - 1;
+    d = astar(G, &S, 0, t, manhattan, NULL);
+    len = sp_path(&S, t, path);
+    printf("0 -> %d 距离 %ld, A* 访问 %d 个顶点, 路径:", t, d, S.count);
+    for (k = 0; k < len; ++k)
+        printf(" %d", path[k]);
+    printf("\n");
+
+    sp_search_free(&S);
+    csr_free(&C);
+    clear_G(G, n);
+    free_buf(G);
+    free_buf(matrix);
+    return bad;
+}
+
 int main(int argc, char *argv[])
 {
     // SET_DEFAULT_LEVEL(CONSOLE_LOGLEVEL_ERR);
@@ -35,15 +110,17 @@ int main(int argc, char *argv[])
 
     scanf("%d %d", &n, &e);
 
-    /* 1. 分配初始化图 */
+    /* 1. 分配初始化图, 边节点从对象池中分配 */
     _Vertex_ *G = calloc_buf(n, _Vertex_);
     init(G, n);
+    obj_pool pool;
+    pool_init(&pool, _adj_node_, 64);
 
     /* 2. 插入 */
     for (i = 0; i < e; ++i) {
         scanf("%d %d", &s, &t);
         (G + s)->id = s;
-        insert(G, s, t, 0);
+        insert_pool(G, s, t, 0, &pool);
     }
 
     double start = START();
@@ -68,9 +145,58 @@ int main(int argc, char *argv[])
     matrix2list((int **)matrix, n, G1);
     show_adj_list(G1, n);
 
+    /* 7. 邻接表与邻接矩阵转 CSR 图 */
+    csr_graph C, C1;
+    csr_from_list(&C, G, n);
+    show_csr(&C);
+    csr_from_matrix(&C1, (int **)matrix, n);
+    show_csr(&C1);
+
+    /* 8. CSR 图转邻接表与邻接矩阵 */
+    _Vertex_ *G2 = calloc_buf(n, _Vertex_);
+    init(G2, n);
+    csr_to_list_pool(&C, G2, &pool);
+    show_adj_list(G2, n);
+    csr_to_matrix(&C, (int **)matrix);
+    show_adj_matrix((int **)matrix, n);
+
+    /* 9. BFS / DFS, 同一个 graph_search 可反复使用 */
+    graph_search S;
+    int path[n], len;
+    graph_search_init(&S, n);
+    for (s = 0; s < n; s += 3) {
+        bfs(G, &S, s);
+        printf("bfs %d:", s);
+        for (i = 0; i < S.count; ++i)
+            printf(" %d(%d)", S.order[i], S.dist[S.order[i]]);
+        len = graph_path(&S, 2, path);
+        printf(", 到 2 的路径:");
+        for (i = 0; i < len; ++i)
+            printf(" %d", path[i]);
+        printf("\n");
+
+        dfs(G, &S, s);
+        printf("dfs %d:", s);
+        for (i = 0; i < S.count; ++i)
+            printf(" %d(%d)", S.order[i], S.parent[S.order[i]]);
+        printf("\n");
+    }
+    graph_search_free(&S);
+
+    /* 10. 邻接矩阵上的全源最短路径, 不可达仍为 WEIGHT_INFTY */
+    floyd_warshall((int **)matrix, n, 2);
+    show_adj_matrix((int **)matrix, n);
+
+    /* 11. 单源/点到点最短路径与 Floyd–Warshall 的结果比较 */
+    shortest_path_demo();
+
     FINISH(start);
 
-    clear_G(G, n);
+    csr_free(&C);
+    csr_free(&C1);
+    free_buf(G2);
+
+    clear_G_pool(G, n, &pool);
     free_buf(G);
     clear_G(G1, n);
     free_buf(G1);
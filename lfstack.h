@@ -0,0 +1,207 @@
+/***************************************************************
+Copyright © wkangk <wangkangchn@163.com>
+文件名		: lfstack.h
+作者	  	: wkangk <wangkangchn@163.com>
+版本	   	: v1.0
+描述	   	: 无锁侵入式栈(Treiber stack)
+			节点 struct lfstack_node 嵌入到用户结构体中, 与 list.h 的 struct list_head 用法相同.
+			栈顶为带标记的指针: 低 48 位为节点地址, 高 16 位为修改计数, 每次 CAS 成功计数加 1,
+			节点出栈后又以相同地址入栈时 CAS 也会失败, 避免 ABA 问题.
+			注意:
+				1. 出栈时会读取可能已被其他线程取走的节点的 next, 因此节点内存在栈仍可能被
+				访问期间不能归还操作系统. 节点来自 obj_pool 或静态数组即可满足要求.
+				2. 仅支持用户态 48 位虚拟地址(x86_64, aarch64)
+			使用方法:
+				1. 使用 lfstack_init(S) 初始化栈
+				2. lfstack_push(S, node) 入栈, lfstack_pop(S) 出栈, 栈空返回 NULL,
+				lfstack_entry(ptr, type, member) 获取节点所在的结构体
+				3. lfstack_pop_all(S) 一次取走全部节点, 返回以 next 串起的链表
+				4. lfpool_xxx 是以 lfstack 作为空闲链表的线程安全对象池
+			e.g.
+				struct task {
+					struct lfstack_node node;
+					int id;
+				};
+				struct lfstack S;
+				lfstack_init(&S);
+
+				lfstack_push(&S, &t->node);
+
+				struct lfstack_node *n = lfstack_pop(&S);
+				if (n)	t = lfstack_entry(n, struct task, node);
+时间	   	: 2026-10-18 20:40
+***************************************************************/
+#ifndef __WKANGK_LFSTACK_H__
+#define __WKANGK_LFSTACK_H__
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <pthread.h>
+#include "tools.h"
+#include "list.h"
+
+_Static_assert(sizeof(void *) == 8, "lfstack.h 需要 64 位指针");
+
+struct lfstack_node {
+	struct lfstack_node *next;
+};
+
+/*
+ * @head:	栈顶, 低 48 位为节点地址, 高 16 位为修改计数
+ */
+struct lfstack {
+	uint64_t head __cacheline_aligned;
+};
+
+#define __LFSTACK_PTR_BITS		48
+#define __LFSTACK_PTR_MASK		((1ULL << __LFSTACK_PTR_BITS) - 1)
+
+/* __lfstack_ptr - 取出栈顶中的节点地址 */
+static inline struct lfstack_node *__lfstack_ptr(uint64_t head)
+{
+	return (struct lfstack_node *)(uintptr_t)(head & __LFSTACK_PTR_MASK);
+}
+
+/* __lfstack_pack - 以 node 为新的栈顶, 修改计数在 old 的基础上加 1 */
+static inline uint64_t __lfstack_pack(struct lfstack_node *node, uint64_t old)
+{
+	return (uint64_t)(uintptr_t)node | ((old & ~__LFSTACK_PTR_MASK) + (1ULL << __LFSTACK_PTR_BITS));
+}
+
+#define lfstack_entry(ptr, type, member)	container_of(ptr, type, member)
+
+static inline void lfstack_init(struct lfstack *s)
+{
+	__atomic_store_n(&s->head, 0, __ATOMIC_RELAXED);
+}
+
+/* lfstack_is_empty - 判断栈是否为空(仅作参考, 读取期间可能被其他线程修改) */
+static inline bool lfstack_is_empty(struct lfstack *s)
+{
+	return __lfstack_ptr(__atomic_load_n(&s->head, __ATOMIC_RELAXED)) == NULL;
+}
+
+/**
+ * lfstack_push_list - 将 first->...->last 整条链表入栈, 只需一次 CAS
+ * @s:		栈
+ * @first:	链表首节点, 入栈后位于栈顶
+ * @last:	链表尾节点
+ * @return:	无
+ */
+static inline void lfstack_push_list(struct lfstack *s, struct lfstack_node *first,
+										struct lfstack_node *last)
+{
+	uint64_t old = __atomic_load_n(&s->head, __ATOMIC_RELAXED);
+
+	assert(((uintptr_t)first & ~__LFSTACK_PTR_MASK) == 0);
+	do {
+		__atomic_store_n(&last->next, __lfstack_ptr(old), __ATOMIC_RELAXED);
+	} while (!__atomic_compare_exchange_n(&s->head, &old, __lfstack_pack(first, old), true,
+											__ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/* lfstack_push - 入栈 */
+static inline void lfstack_push(struct lfstack *s, struct lfstack_node *node)
+{
+	lfstack_push_list(s, node, node);
+}
+
+/**
+ * lfstack_pop - 出栈
+ * @s:		栈
+ * @return:	栈顶节点, 栈空返回 NULL
+ */
+static inline struct lfstack_node *lfstack_pop(struct lfstack *s)
+{
+	uint64_t old = __atomic_load_n(&s->head, __ATOMIC_ACQUIRE);
+	struct lfstack_node *node, *next;
+
+	do {
+		if ((node = __lfstack_ptr(old)) == NULL)
+			return NULL;
+		/* node 可能已被其他线程取走, 读到的 next 无效时修改计数必然已变化, CAS 失败 */
+		next = __atomic_load_n(&node->next, __ATOMIC_RELAXED);
+	} while (!__atomic_compare_exchange_n(&s->head, &old, __lfstack_pack(next, old), true,
+											__ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+	return node;
+}
+
+/**
+ * lfstack_pop_all - 取走栈中全部节点
+ * @s:		栈
+ * @return:	原栈顶节点, 其余节点通过 next 相连, 栈空返回 NULL
+ */
+static inline struct lfstack_node *lfstack_pop_all(struct lfstack *s)
+{
+	uint64_t old = __atomic_load_n(&s->head, __ATOMIC_RELAXED);
+
+	do {
+		if (__lfstack_ptr(old) == NULL)
+			return NULL;
+	} while (!__atomic_compare_exchange_n(&s->head, &old, __lfstack_pack(NULL, old), true,
+											__ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+	return __lfstack_ptr(old);
+}
+
+/*
+            线程安全对象池
+    空闲对象挂在 lfstack 上, 分配/释放无锁; 空闲链表为空时才加锁从 obj_pool 中切分新对象.
+    对象内存只在 lfpool_reset 时归还系统, 满足 lfstack 的要求.
+e.g.
+lfpool pool;
+lfpool_init(&pool, struct node, 256);
+struct node *p = lfpool_alloc(&pool, struct node);
+...
+lfpool_free(&pool, p);
+lfpool_reset(&pool);
+ */
+typedef struct lfpool {
+	struct lfstack free_list;
+	pthread_mutex_t mutex;		/* 保护 pool */
+	obj_pool pool;
+} lfpool;
+
+#define lfpool_init(P, type, n) ({					\
+	lfstack_init(&(P)->free_list);					\
+	pool_init(&(P)->pool, type, n);					\
+	!pthread_mutex_init(&(P)->mutex, NULL);	})
+
+/**
+ * __lfpool_alloc - 从对象池中取出一个清零的对象
+ * @pool:   对象池
+ * @return: 对象地址
+ */
+static inline void *__lfpool_alloc(lfpool *pool)
+{
+	void *obj = lfstack_pop(&pool->free_list);
+
+	if (obj == NULL) {
+		pthread_mutex_lock(&pool->mutex);
+		obj = __pool_alloc(&pool->pool);
+		pthread_mutex_unlock(&pool->mutex);
+		return obj;
+	}
+	/* 其他线程的 lfstack_pop 可能仍在读取 next, 首部用原子操作清零 */
+	__atomic_store_n(&((struct lfstack_node *)obj)->next, NULL, __ATOMIC_RELAXED);
+	memset((char *)obj + sizeof(struct lfstack_node), 0, pool->pool.obj_size - sizeof(struct lfstack_node));
+	return obj;
+}
+
+/* lfpool_alloc - 分配对象, 返回清零的对象 */
+#define lfpool_alloc(P, type)	({ (type *)__lfpool_alloc( (P) ); })
+
+/* lfpool_free - 将对象归还对象池 */
+#define lfpool_free(P, obj)		({ lfstack_push(&(P)->free_list, (struct lfstack_node *)(obj)); })
+
+/* lfpool_reset - 一次性释放全部对象, 调用时不能有其他线程在使用该对象池 */
+#define lfpool_reset(P)	({						\
+	lfstack_init(&(P)->free_list);				\
+	pool_reset(&(P)->pool);	})
+
+/* lfpool_destroy - 释放全部对象并销毁互斥锁 */
+#define lfpool_destroy(P)	({					\
+	lfpool_reset(P);							\
+	pthread_mutex_destroy(&(P)->mutex);	})
+
+#endif // !__WKANGK_LFSTACK_H__
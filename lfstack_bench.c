@@ -0,0 +1,194 @@
+/***************************************************************
+Copyright © wkangk <wangkangchn@163.com>
+文件名		: lfstack_bench.c
+作者	  	: wkangk <wangkangchn@163.com>
+版本	   	: v1.0
+描述	   	: lfstack.h 多线程测试
+            1. 多个线程在同一个 lfstack 上反复 push/pop, 结束后检查节点个数
+            2. 多个线程并发 lfpool_alloc/lfpool_free, 检查对象没有被重复分配,
+            结束后空闲链表中的对象个数等于从对象池中切分出的对象个数
+            3. 与互斥锁保护的 obj_pool 的吞吐量对比
+时间	   	: 2026-10-19 09:10
+***************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+#include "tools.h"
+#include "lfstack.h"
+
+#define NTHREADS    4
+#define BATCH       16          /* 每个线程同时持有的对象个数 */
+const long M = 1000000;         /* 每个线程的操作次数 */
+
+struct task {
+    struct lfstack_node node;
+    int owner;                  /* 持有该对象的线程编号 + 1, 0 表示空闲 */
+    long seq;
+};
+
+static struct lfstack S;
+static struct task tasks[NTHREADS * BATCH];
+static lfpool LP;
+static obj_pool P;
+static pthread_mutex_t P_mutex = PTHREAD_MUTEX_INITIALIZER;
+static long errors;
+
+/* 墙上时间(秒), clock() 统计的是所有线程的 CPU 时间 */
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* 栈上反复出栈再入栈, 节点既不会丢失也不会重复 */
+static void *stack_worker(void *arg)
+{
+    struct lfstack_node *n;
+    long i;
+
+    for (i = 0; i < M; ++i) {
+        if ((n = lfstack_pop(&S)) == NULL)
+            continue;
+        lfstack_push(&S, n);
+    }
+    return NULL;
+}
+
+/**
+ * __check_owner - 取得对象后标记持有者, 对象已被其他线程持有时计为错误
+ * @t:      对象
+ * @id:     线程编号
+ * @seq:    写入对象的序号, 归还时检查
+ */
+static inline void __check_owner(struct task *t, int id, long seq)
+{
+    if (__atomic_exchange_n(&t->owner, id + 1, __ATOMIC_RELAXED) != 0)
+        __atomic_add_fetch(&errors, 1, __ATOMIC_RELAXED);
+    t->seq = seq;
+}
+
+/* __release_owner - 归还对象前检查对象没有被其他线程修改 */
+static inline void __release_owner(struct task *t, int id, long seq)
+{
+    if (t->seq != seq || __atomic_exchange_n(&t->owner, 0, __ATOMIC_RELAXED) != id + 1)
+        __atomic_add_fetch(&errors, 1, __ATOMIC_RELAXED);
+}
+
+static void *lfpool_worker(void *arg)
+{
+    int id = (int)(long)arg, k;
+    struct task *held[BATCH];
+    long i;
+
+    for (i = 0; i < M; i += BATCH) {
+        for (k = 0; k < BATCH; ++k) {
+            held[k] = lfpool_alloc(&LP, struct task);
+            __check_owner(held[k], id, i + k);
+        }
+        for (k = 0; k < BATCH; ++k) {
+            __release_owner(held[k], id, i + k);
+            lfpool_free(&LP, held[k]);
+        }
+    }
+    return NULL;
+}
+
+static void *mutex_pool_worker(void *arg)
+{
+    int id = (int)(long)arg, k;
+    struct task *held[BATCH];
+    long i;
+
+    for (i = 0; i < M; i += BATCH) {
+        for (k = 0; k < BATCH; ++k) {
+            pthread_mutex_lock(&P_mutex);
+            held[k] = pool_alloc(&P, struct task);
+            pthread_mutex_unlock(&P_mutex);
+            __check_owner(held[k], id, i + k);
+        }
+        for (k = 0; k < BATCH; ++k) {
+            __release_owner(held[k], id, i + k);
+            pthread_mutex_lock(&P_mutex);
+            pool_free(&P, held[k]);
+            pthread_mutex_unlock(&P_mutex);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * run - 启动 NTHREADS 个线程执行 fn, 输出每秒操作数
+ * @name:   测试名称
+ * @fn:     线程函数, 参数为线程编号
+ */
+static void run(const char *name, void *(*fn)(void *))
+{
+    pthread_t threads[NTHREADS];
+    double start = now();
+    long i;
+
+    for (i = 0; i < NTHREADS; ++i)
+        pthread_create(threads + i, NULL, fn, (void *)i);
+    for (i = 0; i < NTHREADS; ++i)
+        pthread_join(threads[i], NULL);
+    printf("%-16s %8.2f M ops/s\n", name, 2.0 * NTHREADS * M / (now() - start) / 1e6);
+}
+
+/* carved - 已从对象池中切分出的对象个数 */
+static long carved(obj_pool *pool)
+{
+    long n = 0;
+
+    for (void *block = pool->blocks; block; block = *(void **)block)
+        n += pool->per_block;
+    return n - (pool->end - pool->cur) / pool->obj_size;
+}
+
+/* list_length - pop_all 得到的链表长度 */
+static long list_length(struct lfstack_node *n)
+{
+    long len = 0;
+
+    for (; n; n = n->next)
+        ++len;
+    return len;
+}
+
+int main(int argc, char *argv[])
+{
+    long len, expect;
+    int i;
+
+    printf("%d 个线程, 每个线程 %ld 次操作\n", NTHREADS, M);
+
+    /* 1. lfstack push/pop */
+    lfstack_init(&S);
+    for (i = 0; i < NTHREADS * BATCH; ++i)
+        lfstack_push(&S, &tasks[i].node);
+    run("lfstack", stack_worker);
+    len = list_length(lfstack_pop_all(&S));
+    printf("\t栈中节点 %ld 个, 应为 %d 个%s\n", len, NTHREADS * BATCH,
+            len == NTHREADS * BATCH ? "" : " (错误!)");
+
+    /* 2. lfpool alloc/free */
+    errors = 0;
+    if (!lfpool_init(&LP, struct task, 64))
+        return 1;
+    run("lfpool", lfpool_worker);
+    len = list_length(lfstack_pop_all(&LP.free_list));
+    expect = carved(&LP.pool);
+    printf("\t空闲对象 %ld 个, 切分对象 %ld 个, 重复分配 %ld 次%s\n", len, expect, errors,
+            len == expect && errors == 0 ? "" : " (错误!)");
+    lfpool_destroy(&LP);
+
+    /* 3. 互斥锁 + obj_pool */
+    errors = 0;
+    pool_init(&P, struct task, 64);
+    run("mutex obj_pool", mutex_pool_worker);
+    printf("\t重复分配 %ld 次%s\n", errors, errors == 0 ? "" : " (错误!)");
+    pool_reset(&P);
+    return 0;
+}
@@ -74,6 +74,24 @@ int main(int argc, char *argv[])
     /* 4. 测试空 */
     printf("%s\n", list_empty(header) ? "空" : "非空");
 
+    /* 5. 节点从对象池中分配, 清空链表时一次性释放全部节点 */
+    obj_pool pool;
+    pool_init(&pool, test_list, 64);
+    for (i = 0; i < 5; i++) {
+        node = pool_alloc(&pool, test_list);
+        node->num = i;
+        list_add_tail(&(node->list), header);
+    }
+
+    printf("对象池节点(期望输出): 0 1 2 3 4\n");
+    list_for_each_entry(node, header, list)
+        printf("%d ", node->num);
+    printf("\n");
+
+    pool_reset(&pool);
+    INIT_LIST_HEAD(header);
+    printf("%s\n", list_empty(header) ? "空" : "非空");
+
     free_buf(header);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,235 @@
+/***************************************************************
+Copyright © wkangk <wangkangchn@163.com>
+文件名		: mpmc_queue.h
+作者	  	: wkangk <wangkangchn@163.com>
+版本	   	: v1.0
+描述	   	: 多生产者多消费者有界队列
+			每个槽位带有序号 seq, 生产者/消费者通过 CAS 抢占 enqueue_pos/dequeue_pos
+			后直接读写槽位, 不需要加锁(无锁快速路径).
+			队列满/空时, 阻塞操作在条件变量上等待, 由对端在操作成功后唤醒,
+			工作线程可以挂起而不是空转.
+			使用方法:
+				1. 使用 DEFINE_MPMC_QUEUE_ELEMENT_TYPE(type, name) 定义使用的队列元素类型
+				其中:
+					type: 指定队列数组类型
+					name: 结构体名称
+				2. 使用 mpmc_init(Q, len) 来初始化队列结构体元素
+				其中:
+					len: 队列的最大长度, 向上取整为 2 的幂
+				3. mpmc_try_push/mpmc_try_pop 队列满/空时立即返回 false,
+				mpmc_push/mpmc_pop 队列满/空时阻塞,
+				mpmc_pop_timed 最多等待 ms 毫秒
+			e.g.
+				DEFINE_MPMC_QUEUE_ELEMENT_TYPE(int, mpmc_queue);
+
+				mpmc_queue *Q = calloc(1, sizeof(mpmc_queue));
+				mpmc_init(Q, 1024);
+
+				生产者:	mpmc_push(Q, x);
+				消费者:	mpmc_pop(Q, &x);
+						if (mpmc_pop_timed(Q, &x, 100)) ...
+
+				mpmc_clear(Q);
+				free(Q);
+时间	   	: 2026-10-18 18:40
+***************************************************************/
+#ifndef __WKANGK_MPMC_QUEUE_H__
+#define __WKANGK_MPMC_QUEUE_H__
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+#include "tools.h"
+
+/*
+ * @enqueue_pos:	下一个入队位置
+ * @dequeue_pos:	下一个出队位置
+ * @cells:			槽位, seq == pos 时可写入, seq == pos + 1 时可读出
+ * @push_waiters:	阻塞在 not_full 上的生产者个数
+ * @pop_waiters:	阻塞在 not_empty 上的消费者个数
+ */
+#define DEFINE_MPMC_QUEUE_ELEMENT_TYPE(type, name)		\
+	typedef struct name {							\
+		size_t enqueue_pos __cacheline_aligned;		\
+		size_t dequeue_pos __cacheline_aligned;		\
+		size_t mask __cacheline_aligned;			\
+		struct {									\
+			size_t seq;								\
+			type data;								\
+		} *cells;									\
+		pthread_mutex_t mutex;						\
+		pthread_cond_t not_full;					\
+		pthread_cond_t not_empty;					\
+		unsigned int push_waiters;					\
+		unsigned int pop_waiters;					\
+	} name
+
+/* 成功返回1, 失败返回0 */
+#define mpmc_init(Q, len) ({										\
+		(Q)->mask = roundup_pow_of_two(max((size_t)(len), (size_t)2)) - 1;	\
+		(Q)->enqueue_pos = (Q)->dequeue_pos = 0;					\
+		(Q)->push_waiters = (Q)->pop_waiters = 0;					\
+		(Q)->cells = calloc((Q)->mask + 1, sizeof(*(Q)->cells));	\
+		for (size_t __i = 0; (Q)->cells && __i <= (Q)->mask; ++__i)	\
+			(Q)->cells[__i].seq = __i;								\
+		(Q)->cells && !pthread_mutex_init(&(Q)->mutex, NULL)		\
+			&& !pthread_cond_init(&(Q)->not_full, NULL)				\
+			&& !pthread_cond_init(&(Q)->not_empty, NULL);	})
+
+/* mpmc_size - 获取队列长度(仅作参考, 读取期间可能被其他线程修改) */
+#define mpmc_size(Q)		({	\
+	__atomic_load_n(&(Q)->enqueue_pos, __ATOMIC_RELAXED) - __atomic_load_n(&(Q)->dequeue_pos, __ATOMIC_RELAXED); })
+
+/**
+ * mpmc_try_push - 入队, 不阻塞
+ * @Q:		队列
+ * @x:		待入队元素
+ * @return:	成功返回 true, 队列满返回 false
+ */
+#define mpmc_try_push(Q, x) ({											\
+	typeof( (Q)->cells ) __cell;										\
+	size_t __pos = __atomic_load_n(&(Q)->enqueue_pos, __ATOMIC_RELAXED);	\
+	intptr_t __diff;													\
+	bool __ok = false;													\
+	for (; ;) {															\
+		__cell = (Q)->cells + (__pos & (Q)->mask);						\
+		__diff = (intptr_t)__atomic_load_n(&__cell->seq, __ATOMIC_ACQUIRE) - (intptr_t)__pos;	\
+		if (__diff == 0) {												\
+			if (__atomic_compare_exchange_n(&(Q)->enqueue_pos, &__pos, __pos + 1, true,	\
+						__ATOMIC_RELAXED, __ATOMIC_RELAXED)) {			\
+				__ok = true;											\
+				break;													\
+			}															\
+		} else if (__diff < 0)											\
+			break;						/* 队列满 */					\
+		else															\
+			__pos = __atomic_load_n(&(Q)->enqueue_pos, __ATOMIC_RELAXED);	\
+	}																	\
+	if (__ok) {															\
+		__cell->data = (x);												\
+		__atomic_store_n(&__cell->seq, __pos + 1, __ATOMIC_RELEASE);	\
+	}																	\
+	__ok; })
+
+/**
+ * mpmc_try_pop - 出队, 不阻塞
+ * @Q:		队列
+ * @px:		保存出队元素的地址
+ * @return:	成功返回 true, 队列空返回 false
+ */
+#define mpmc_try_pop(Q, px) ({											\
+	typeof( (Q)->cells ) __cell;										\
+	size_t __pos = __atomic_load_n(&(Q)->dequeue_pos, __ATOMIC_RELAXED);	\
+	intptr_t __diff;													\
+	bool __ok = false;													\
+	for (; ;) {															\
+		__cell = (Q)->cells + (__pos & (Q)->mask);						\
+		__diff = (intptr_t)__atomic_load_n(&__cell->seq, __ATOMIC_ACQUIRE) - (intptr_t)(__pos + 1);	\
+		if (__diff == 0) {												\
+			if (__atomic_compare_exchange_n(&(Q)->dequeue_pos, &__pos, __pos + 1, true,	\
+						__ATOMIC_RELAXED, __ATOMIC_RELAXED)) {			\
+				__ok = true;											\
+				break;													\
+			}															\
+		} else if (__diff < 0)											\
+			break;						/* 队列空 */					\
+		else															\
+			__pos = __atomic_load_n(&(Q)->dequeue_pos, __ATOMIC_RELAXED);	\
+	}																	\
+	if (__ok) {															\
+		*(px) = __cell->data;											\
+		__atomic_store_n(&__cell->seq, __pos + (Q)->mask + 1, __ATOMIC_RELEASE);	\
+	}																	\
+	__ok; })
+
+/**
+ * __mpmc_wake - 有线程在 cond 上等待时唤醒其中一个
+ *		fence 与 __mpmc_wait 中的 fence 配对: 等待者登记后必然能看到本次操作的结果,
+ *		或者本线程必然能看到等待者的登记
+ */
+#define __mpmc_wake(Q, waiters, cond) ({						\
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);					\
+	if (__atomic_load_n(&(Q)->waiters, __ATOMIC_RELAXED)) {		\
+		pthread_mutex_lock(&(Q)->mutex);						\
+		pthread_cond_signal(&(Q)->cond);						\
+		pthread_mutex_unlock(&(Q)->mutex);						\
+	}	})
+
+/**
+ * __mpmc_wait - 登记为等待者, 在 cond 上等待直到 try_op 成功或超时
+ * @try_op:		非阻塞操作表达式, 成功时为 true
+ * @deadline:	绝对超时时间(struct timespec *), 为 NULL 时一直等待
+ * @return:		try_op 成功返回 true, 超时返回 false
+ */
+#define __mpmc_wait(Q, waiters, cond, try_op, deadline) ({		\
+	const struct timespec *__dl = (deadline);					\
+	bool __done;												\
+	int __err = 0;												\
+	pthread_mutex_lock(&(Q)->mutex);							\
+	__atomic_add_fetch(&(Q)->waiters, 1, __ATOMIC_SEQ_CST);		\
+	for (; ;) {													\
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);				\
+		if ((__done = (try_op)) || __err)	break;				\
+		if (__dl == NULL)										\
+			pthread_cond_wait(&(Q)->cond, &(Q)->mutex);			\
+		else													\
+			__err = pthread_cond_timedwait(&(Q)->cond, &(Q)->mutex, __dl);	\
+	}															\
+	__atomic_sub_fetch(&(Q)->waiters, 1, __ATOMIC_SEQ_CST);		\
+	pthread_mutex_unlock(&(Q)->mutex);							\
+	__done; })
+
+/**
+ * mpmc_push - 入队, 队列满时阻塞
+ * @Q:		队列
+ * @x:		待入队元素
+ */
+#define mpmc_push(Q, x) ({										\
+	typeof( (Q)->cells->data ) __val = (x);						\
+	if (!mpmc_try_push(Q, __val))								\
+		__mpmc_wait(Q, push_waiters, not_full, mpmc_try_push(Q, __val), (struct timespec *)NULL);	\
+	__mpmc_wake(Q, pop_waiters, not_empty);	})
+
+/**
+ * mpmc_pop - 出队, 队列空时阻塞
+ * @Q:		队列
+ * @px:		保存出队元素的地址
+ */
+#define mpmc_pop(Q, px) ({										\
+	if (!mpmc_try_pop(Q, (px)))									\
+		__mpmc_wait(Q, pop_waiters, not_empty, mpmc_try_pop(Q, (px)), (struct timespec *)NULL);	\
+	__mpmc_wake(Q, push_waiters, not_full);	})
+
+/**
+ * mpmc_pop_timed - 出队, 队列空时最多等待 ms 毫秒
+ * @Q:		队列
+ * @px:		保存出队元素的地址
+ * @ms:		最长等待时间(毫秒)
+ * @return:	成功返回 true, 超时返回 false
+ */
+#define mpmc_pop_timed(Q, px, ms) ({							\
+	struct timespec __deadline;									\
+	bool __got = mpmc_try_pop(Q, (px));							\
+	if (!__got) {												\
+		clock_gettime(CLOCK_REALTIME, &__deadline);				\
+		__deadline.tv_sec += (ms) / 1000;						\
+		__deadline.tv_nsec += (long)((ms) % 1000) * 1000000;	\
+		if (__deadline.tv_nsec >= 1000000000) {					\
+			++__deadline.tv_sec;								\
+			__deadline.tv_nsec -= 1000000000;					\
+		}														\
+		__got = __mpmc_wait(Q, pop_waiters, not_empty, mpmc_try_pop(Q, (px)), &__deadline);	\
+	}															\
+	if (__got)													\
+		__mpmc_wake(Q, push_waiters, not_full);					\
+	__got; })
+
+/* mpmc_clear - 释放缓冲区 */
+#define mpmc_clear(Q) ({						\
+	pthread_cond_destroy(&(Q)->not_full);		\
+	pthread_cond_destroy(&(Q)->not_empty);		\
+	pthread_mutex_destroy(&(Q)->mutex);			\
+	free( (Q)->cells ); })
+
+#endif // !__WKANGK_MPMC_QUEUE_H__
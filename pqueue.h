@@ -17,7 +17,12 @@ Copyright © wkangk <wangkangchn@163.com>
 
 				3. 使用 pqinit(Q, max, compare) 来初始化队列结构体元素
 				其中:
-					max:        队列的最大长度
+					max:        队列的初始容量, 插入超过容量时自动按 2 倍扩容, 
+                                可使用 pqreserve(Q, n) 预留可容纳 n 个元素的空间
+                使用 pqinit_dary(Q, max, compare, d) 初始化 d 叉堆(d = 2, 4, 8), 
+                同一节点的 d 个孩子在数组中连续存放, 且第一个孩子的下标为 d 的倍数, 
+                堆数组按缓存行对齐, d * sizeof(type) 不超过缓存行时一组孩子位于同一缓存行内, 
+                堆较大时可减少下沉过程中的缓存缺失
                     compare:    为函数指针, 用于比较优先级队列元素, 详细介绍间下方
                 Note:
                     pqinit 初始化失败时会触发断言失败, 成功无返回值
@@ -40,12 +45,25 @@ Copyright © wkangk <wangkangchn@163.com>
                 free(Q);
                 return 0;
             }
+
+        4. 比较操作在编译期确定时, 使用 DEFINE_PQUEUE_ELEMENT_TYPE_CMP(type, name, cmp) 定义, 
+        比较直接内联展开, 不再经过函数指针. 其中 cmp 为宏或 inline 函数, 参数与返回值同 compare.
+        定义后使用 name_push(Q, val), name_pop(Q) 插入与弹出, pqinit 的 compare 参数传 NULL 即可.
+        e.g.
+            #define int_compare(a, b)   ( (*(a) > *(b)) - (*(a) < *(b)) )
+            DEFINE_PQUEUE_ELEMENT_TYPE_CMP(int, ipqueue, int_compare);
+
+            ipqueue *Q = calloc(1, sizeof(ipqueue));
+            pqinit(Q, MAX, NULL);
+            ipqueue_push(Q, key);
+            ipqueue_pop(Q);
 时间	   	: 2020-09-11 09:54
 ***************************************************************/
 #ifndef __PQUEUE_H__   
 #define __PQUEUE_H__   
 #include <assert.h>
 #include <stdlib.h>
+#include "tools.h"
 
 /* 函数指针, 用于比较优先级队列元素, 其返回值必须满足
     arg1 < arg2时， 返回值 < 0;
@@ -70,48 +88,120 @@ int compare(const void *arg1, const void *arg2)
 typedef int (*__compare_fn)(const void *, const void *);
 
 /* 
+ * @capacity:      heap 数组的长度(根结点位于 heap[d - 1], 之前的位置不使用)
+ * @shift:         log2(堆的叉数)
  * @__compare:     函数指针比较队列元素的大小
  *  */
-#define DEFINE_PQUEUE_ELEMENT_TYPE(type, name)	\
-    typedef struct name {   \
+#define __PQUEUE_STRUCT(type, name)	\
+    struct name {           \
         size_t count;       \
+        size_t capacity;    \
+        unsigned int shift; \
         type *heap;         \
         __compare_fn __compare; \
-    } name
+    }
+
+#define DEFINE_PQUEUE_ELEMENT_TYPE(type, name)	\
+    typedef __PQUEUE_STRUCT(type, name) name
 
 #define parnet(id)      ({ (id) >> 1; })
 #define left(id)        ({ (id) << 1; })
 #define right(id)       ({ ( (id) << 1 ) + 1; })
 
+/* 
+ * d 叉堆(d = 1 << shift)的根结点位于下标 d - 1, 结点 id 的孩子为 
+ * [d * (id - d + 2), d * (id - d + 2) + d - 1], 每组孩子的起始下标均为 d 的倍数.
+ * d = 2 时与传统的 1 起始二叉堆相同.
+ */
+#define __pqroot(Q)         ({ ( (size_t)1 << (Q)->shift ) - 1; })
+#define __pqlast(Q)         ({ (Q)->count + __pqroot(Q) - 1; })
+#define __pqparent(Q, id)   ({ ( (id) >> (Q)->shift ) + __pqroot(Q) - 1; })
+#define __pqchild(Q, id)    ({ ( (id) - __pqroot(Q) + 1 ) << (Q)->shift; })
+
+/**
+ * __pq_aligned_realloc - 按缓存行对齐重新分配堆数组, 保留原数组中的前 old_size 字节
+ * @old:        原数组, 可以为 NULL
+ * @old_size:   需要保留的字节数
+ * @size:       新数组的字节数
+ * @return:     新数组, 失败返回 NULL
+ */
+static inline void *__pq_aligned_realloc(void *old, size_t old_size, size_t size)
+{
+    /* aligned_alloc 要求大小为对齐值的整数倍 */
+    void *heap = aligned_alloc(CACHELINE_SIZE, (size + CACHELINE_SIZE - 1) & ~(size_t)(CACHELINE_SIZE - 1));
+
+    if (heap && old)
+        memcpy(heap, old, old_size);
+    free(old);
+    return heap;
+}
+
 /**
- * pqinit - 初始化有限队列
+ * pqinit_dary - 初始化 d 叉堆实现的优先队列
+ * @max:    初始容量
+ * @d:      堆的叉数, 必须为 2 的幂
  * @return: 失败产生断言错误
  */
-#define pqinit(Q, max, compare) ({					        \
+#define pqinit_dary(Q, max, compare, d) ({                  \
+        unsigned int __arity = (d);                         \
+        assert(__arity >= 2 && !(__arity & (__arity - 1))); \
         (Q)->count = 0;                                     \
-        (Q)->heap = calloc((max), sizeof(*(Q)->heap));      \
+        (Q)->shift = __builtin_ctz(__arity);                \
+        (Q)->capacity = (size_t)(max) + __pqroot(Q);        \
+        (Q)->heap = __pq_aligned_realloc(NULL, 0, (Q)->capacity * sizeof(*(Q)->heap));  \
         assert((Q)->heap);                                  \
-        (Q)->__compare = (compare);                      \
+        (Q)->__compare = (compare);                         \
 })
 
 /**
- * max_henpify - 从根结点 i 向叶结点方向寻找 __heap[i] 值的恰当位置
- * @heap:       堆指针
+ * pqinit - 初始化有限队列(二叉堆)
+ * @max:    初始容量
+ * @return: 失败产生断言错误
+ */
+#define pqinit(Q, max, compare)     pqinit_dary(Q, max, compare, 2)
+
+/**
+ * pqreserve - 预留可容纳 n 个元素的空间, 容量足够时不做任何操作
+ * @Q:      优先队列
+ * @n:      元素个数
+ * @return: 失败产生断言错误
+ */
+#define pqreserve(Q, n) ({                                  \
+        size_t __cap = (size_t)(n) + __pqroot(Q);           \
+        if (__cap > (Q)->capacity) {                        \
+            (Q)->heap = __pq_aligned_realloc((Q)->heap, (__pqlast(Q) + 1) * sizeof(*(Q)->heap),  \
+                                                __cap * sizeof(*(Q)->heap));                    \
+            assert((Q)->heap);                              \
+            (Q)->capacity = __cap;                          \
+        }                                                   \
+})
+
+/* __pqgrow - 队列已满时容量翻倍, 保证插入的均摊代价为 O(1) */
+#define __pqgrow(Q) ({                                      \
+        if (__pqlast(Q) + 1 >= (Q)->capacity)               \
+            pqreserve(Q, max((Q)->count * 2, (size_t)4));   \
+})
+
+/**
+ * __pqsift_down - 从根结点 i 向叶结点方向寻找 __heap[i] 值的恰当位置
+ * @Q:          优先队列
  * @root:       根节点
+ * @cmp:        比较函数/宏, 调用形式为 cmp(&a, &b)
  */
-#define max_henpify(Q, root)    ({  \
-    size_t __n = (Q)->count;                   \
+#define __pqsift_down(Q, root, cmp)    ({  \
+    size_t __n = __pqlast(Q);                  \
     typeof( (Q)->heap ) __heap = (Q)->heap;   \
-    int __root = (root);                \
-    int __left, __right, __largest;     \
+    size_t __root = (root);                \
+    size_t __child, __last, __largest;     \
 \
     for(; ;) {                          \
-        __left = left(__root);        \
-        __right = right(__root);      \
+        __child = __pqchild(Q, __root); \
+        __last = min(__child + ( (size_t)1 << (Q)->shift ) - 1, __n);  \
         __largest = __root;             \
 \
-        if ( (__left  <= __n) && ( (Q)->__compare( (Q)->heap + __left,  (Q)->heap + __root    ) > 0) ) __largest = __left;    \
-        if ( (__right <= __n) && ( (Q)->__compare( (Q)->heap + __right, (Q)->heap + __largest ) > 0) ) __largest = __right;   \
+        /* 在连续存放的孩子中寻找最大值 */ \
+        for (; __child <= __last; ++__child)    \
+            if ( cmp( __heap + __child, __heap + __largest ) > 0 ) __largest = __child;  \
 \
         if (__largest != __root) {      \
             swap(__heap + __root, __heap + __largest);  \
@@ -122,36 +212,89 @@ typedef int (*__compare_fn)(const void *, const void *);
 })
 
 /**
- * pqpush - 向优先队列插入元素 
+ * __pqsift_up - 从结点 i 向根节点方向寻找 __heap[i] 值的恰当位置
  *     只有小于 0 才交换, 相同元素不进行交换
- * @heap:   优先队列指针
- * @key:    待插入值    
+ * @Q:          优先队列
+ * @id:         结点
+ * @cmp:        比较函数/宏, 调用形式为 cmp(&a, &b)
+ */
+#define __pqsift_up(Q, id, cmp)    ({  \
+    typeof( (Q)->heap ) __heap = (Q)->heap;   \
+    for (size_t __i = (id);             \
+        (__i > __pqroot(Q)) && ( cmp( __heap + __pqparent(Q, __i), __heap + __i ) < 0 ); \
+        __i = __pqparent(Q, __i))       \
+        swap(__heap + __i, __heap + __pqparent(Q, __i));   \
+})
+
+/**
+ * max_henpify - 从根结点 i 向叶结点方向寻找 __heap[i] 值的恰当位置
+ * @heap:       堆指针
+ * @root:       根节点
+ */
+#define max_henpify(Q, root)    __pqsift_down(Q, root, (Q)->__compare)
+
+/**
+ * pqpush_cmp - 向优先队列插入元素, 使用指定的比较函数/宏
+ * @Q:      优先队列指针
+ * @val:    待插入值    
+ * @cmp:    比较函数/宏, 为宏或 inline 函数时比较被内联
  */
-#define pqpush(Q, val) ({          \
+#define pqpush_cmp(Q, val, cmp) ({          \
     typeof( *( (Q)->heap ) ) __val = (val); \
-    (Q)->heap[++((Q)->count)] = __val;    \
-    for (size_t i = (Q)->count; \
-        (i > 1) && ((Q)->__compare((Q)->heap + parnet(i), (Q)->heap + i) < 0); \
-        i = parnet(i))    \
-        swap((Q)->heap + i, (Q)->heap + parnet(i));     \
+    __pqgrow(Q);                          \
+    ++(Q)->count;                         \
+    (Q)->heap[__pqlast(Q)] = __val;       \
+    __pqsift_up(Q, __pqlast(Q), cmp);     \
 })
 
 /**
- * pqpop - 获取优先队列的最大值而后删除
- * @Q:	优先队列
+ * pqpop_cmp - 获取优先队列的最大值而后删除, 使用指定的比较函数/宏
+ * @Q:	    优先队列
+ * @cmp:    比较函数/宏, 为宏或 inline 函数时比较被内联
  * @return: 优先队列中的最大值
  */
-#define pqpop(Q) ({      \
-    typeof( (Q)->heap ) __heap = (Q)->heap;    \
+#define pqpop_cmp(Q, cmp) ({      \
+    typeof( (Q)->heap ) __hp = (Q)->heap;    \
     assert((Q)->count);  \
-    typeof( *__heap ) __max = __heap[1];        \
-    __heap[1] = __heap[(Q)->count--];           \
-    max_henpify(Q, 1);         \
+    typeof( *__hp ) __max = __hp[__pqroot(Q)];      \
+    __hp[__pqroot(Q)] = __hp[__pqlast(Q)];          \
+    --(Q)->count;               \
+    __pqsift_down(Q, __pqroot(Q), cmp);   \
     __max;                                      \
 })   
 
+/**
+ * pqpush - 向优先队列插入元素 
+ *     只有小于 0 才交换, 相同元素不进行交换
+ * @heap:   优先队列指针
+ * @key:    待插入值    
+ */
+#define pqpush(Q, val)      pqpush_cmp(Q, val, (Q)->__compare)
+
+/**
+ * pqpop - 获取优先队列的最大值而后删除
+ * @Q:	优先队列
+ * @return: 优先队列中的最大值
+ */
+#define pqpop(Q)            pqpop_cmp(Q, (Q)->__compare)
+
+/**
+ * 定义比较操作在编译期确定的优先队列, 并生成 name_push, name_pop 
+ * @type:   队列元素类型
+ * @name:   结构体名称
+ * @cmp:    比较宏或 inline 函数, 调用形式为 cmp(&a, &b)
+ * 与其他 DEFINE_* 宏相同, 以 typedef 结尾, 使用时后接分号
+ */
+#define DEFINE_PQUEUE_ELEMENT_TYPE_CMP(type, name, cmp)          \
+    __PQUEUE_STRUCT(type, name);                                \
+    static inline void name ## _push(struct name *Q, type val)  \
+    {   pqpush_cmp(Q, val, cmp);    }                           \
+    static inline type name ## _pop(struct name *Q)             \
+    {   return pqpop_cmp(Q, cmp);   }                           \
+    typedef struct name name
+
 /* pqtop - 查看队首元素 */
-#define pqtop(Q) 			({ ((Q)->heap)[1]; })
+#define pqtop(Q) 			({ ((Q)->heap)[__pqroot(Q)]; })
 
 /* pqclear - 清空优先队列 */
 #define pqclear(Q)          ({ free((Q)->heap); })
@@ -162,4 +305,183 @@ typedef int (*__compare_fn)(const void *, const void *);
 /* pqsize - 获取优先队列元素个数 */
 #define pqsize(Q)          ({ (Q)->count; })
 
+
+/* ==============================================================================
+ *                              索引优先队列
+ *
+ * 队列元素为 (id, key), id 取值范围为 [0, n), 同一 id 在队列中最多出现一次.
+ * 通过 pos 记录每个 id 在堆中的位置, 支持 ipqcontains 与 ipqdecrease_key, 
+ * 用于 Dijkstra 等需要更新键值的算法, 堆的大小不超过 n.
+ * 与 pqueue 相同, compare 返回值最大的 key 位于队首, 求最小值时反向比较即可.
+ * 使用方法:
+ *      DEFINE_IPQUEUE_ELEMENT_TYPE(int, ipqueue);
+ *
+ *      ipqueue *Q = calloc(1, sizeof(ipqueue));
+ *      ipqinit(Q, n, compare);
+ *      ipqpush(Q, id, key);
+ *      if (ipqcontains(Q, id))
+ *          ipqdecrease_key(Q, id, key);
+ *      id = ipqpop(Q);
+ *      ipqclear(Q);
+ * ============================================================================== */
+
+/* 
+ * @n:      id 的取值范围
+ * @heap:   与 pqueue 相同的布局, heap[d - 1] 为根结点, 存放 id
+ * @pos:    pos[id] 为 id 在 heap 中的下标, 不在队列中时为 0(根结点下标至少为 1)
+ * @keys:   keys[id] 为 id 的键值
+ *  */
+#define DEFINE_IPQUEUE_ELEMENT_TYPE(type, name)	\
+    typedef struct name {   \
+        size_t count;       \
+        size_t n;           \
+        unsigned int shift; \
+        int *heap;          \
+        size_t *pos;        \
+        type *keys;         \
+        __compare_fn __compare; \
+    } name
+
+/**
+ * ipqinit_dary - 初始化 d 叉堆实现的索引优先队列
+ * @num:    id 的取值范围
+ * @d:      堆的叉数, 必须为 2 的幂
+ * @return: 失败产生断言错误
+ */
+#define ipqinit_dary(Q, num, compare, d) ({                 \
+        unsigned int __arity = (d);                         \
+        assert(__arity >= 2 && !(__arity & (__arity - 1))); \
+        (Q)->count = 0;                                     \
+        (Q)->n = (num);                                     \
+        (Q)->shift = __builtin_ctz(__arity);                \
+        (Q)->heap = __pq_aligned_realloc(NULL, 0, ((Q)->n + __pqroot(Q)) * sizeof(*(Q)->heap));   \
+        (Q)->pos = calloc((Q)->n, sizeof(*(Q)->pos));       \
+        (Q)->keys = calloc((Q)->n, sizeof(*(Q)->keys));     \
+        assert((Q)->heap && (Q)->pos && (Q)->keys);         \
+        (Q)->__compare = (compare);                         \
+})
+
+/**
+ * ipqinit - 初始化索引优先队列(二叉堆)
+ * @num:    id 的取值范围
+ * @return: 失败产生断言错误
+ */
+#define ipqinit(Q, num, compare)    ipqinit_dary(Q, num, compare, 2)
+
+/**
+ * __ipqsift_up - 从堆下标 i 向根方向寻找 heap[i] 的恰当位置
+ * @cmp:    比较函数/宏, 调用形式为 cmp(&key1, &key2)
+ */
+#define __ipqsift_up(Q, i, cmp) ({  \
+    size_t __i = (i), __p;          \
+    int __v = (Q)->heap[__i];       \
+    while (__i > __pqroot(Q)) {     \
+        __p = __pqparent(Q, __i);   \
+        if ( cmp( (Q)->keys + (Q)->heap[__p], (Q)->keys + __v ) >= 0 ) break;    \
+        (Q)->heap[__i] = (Q)->heap[__p];        \
+        (Q)->pos[(Q)->heap[__i]] = __i;         \
+        __i = __p;                  \
+    }                               \
+    (Q)->heap[__i] = __v;           \
+    (Q)->pos[__v] = __i;            \
+})
+
+/**
+ * __ipqsift_down - 从堆下标 i 向叶方向寻找 heap[i] 的恰当位置
+ * @cmp:    比较函数/宏, 调用形式为 cmp(&key1, &key2)
+ */
+#define __ipqsift_down(Q, i, cmp) ({    \
+    size_t __i = (i), __n = __pqlast(Q);    \
+    size_t __c, __last, __best;         \
+    int __v = (Q)->heap[__i];           \
+    for (; ;) {                         \
+        __c = __pqchild(Q, __i);        \
+        if (__c > __n)  break;          \
+        __last = min(__c + ( (size_t)1 << (Q)->shift ) - 1, __n);  \
+        for (__best = __c++; __c <= __last; ++__c)                 \
+            if ( cmp( (Q)->keys + (Q)->heap[__c], (Q)->keys + (Q)->heap[__best] ) > 0 ) __best = __c;    \
+        if ( cmp( (Q)->keys + (Q)->heap[__best], (Q)->keys + __v ) <= 0 ) break;  \
+        (Q)->heap[__i] = (Q)->heap[__best]; \
+        (Q)->pos[(Q)->heap[__i]] = __i;     \
+        __i = __best;                   \
+    }                                   \
+    (Q)->heap[__i] = __v;               \
+    (Q)->pos[__v] = __i;                \
+})
+
+/* ipqcontains - 判断 id 是否在队列中 */
+#define ipqcontains(Q, id)      ({ (Q)->pos[(id)] != 0; })
+
+/* ipqkey - 获取 id 的键值 */
+#define ipqkey(Q, id)           ({ (Q)->keys[(id)]; })
+
+/**
+ * ipqpush_cmp - 插入 (id, key), id 不能已在队列中
+ * @cmp:    比较函数/宏, 为宏或 inline 函数时比较被内联
+ */
+#define ipqpush_cmp(Q, id, key, cmp) ({ \
+    int __id = (id);                    \
+    assert(__id >= 0 && (size_t)__id < (Q)->n && !ipqcontains(Q, __id));  \
+    (Q)->keys[__id] = (key);            \
+    ++(Q)->count;                       \
+    (Q)->heap[__pqlast(Q)] = __id;      \
+    __ipqsift_up(Q, __pqlast(Q), cmp);  \
+})
+
+/**
+ * ipqdecrease_key_cmp - 将队列中 id 的键值更新为优先级更高的 key
+ * @cmp:    比较函数/宏, 为宏或 inline 函数时比较被内联
+ */
+#define ipqdecrease_key_cmp(Q, id, key, cmp) ({ \
+    int __id = (id);                    \
+    assert(ipqcontains(Q, __id));       \
+    (Q)->keys[__id] = (key);            \
+    __ipqsift_up(Q, (Q)->pos[__id], cmp);   \
+})
+
+/**
+ * ipqpop_cmp - 弹出优先级最高的元素
+ * @cmp:    比较函数/宏, 为宏或 inline 函数时比较被内联
+ * @return: 元素的 id, 键值可通过 ipqkey 获取
+ */
+#define ipqpop_cmp(Q, cmp) ({           \
+    assert((Q)->count);                 \
+    int __top = (Q)->heap[__pqroot(Q)]; \
+    int __tail = (Q)->heap[__pqlast(Q)];    \
+    --(Q)->count;                       \
+    (Q)->pos[__top] = 0;                \
+    if ((Q)->count) {                   \
+        (Q)->heap[__pqroot(Q)] = __tail;    \
+        __ipqsift_down(Q, __pqroot(Q), cmp);    \
+    }                                   \
+    __top;                              \
+})
+
+#define ipqpush(Q, id, key)             ipqpush_cmp(Q, id, key, (Q)->__compare)
+#define ipqdecrease_key(Q, id, key)     ipqdecrease_key_cmp(Q, id, key, (Q)->__compare)
+#define ipqpop(Q)                       ipqpop_cmp(Q, (Q)->__compare)
+
+/* ipqtop - 查看队首元素的 id */
+#define ipqtop(Q)               ({ (Q)->heap[__pqroot(Q)]; })
+
+/* ipqreset - 清空队列中的元素, 保留已分配的空间以便复用 */
+#define ipqreset(Q) ({                              \
+    for (size_t __k = __pqroot(Q); __k <= __pqlast(Q); ++__k)  \
+        (Q)->pos[(Q)->heap[__k]] = 0;               \
+    (Q)->count = 0;                                 \
+})
+
+/* ipqclear - 释放索引优先队列 */
+#define ipqclear(Q) ({      \
+    free((Q)->heap);        \
+    free((Q)->pos);         \
+    free((Q)->keys);        \
+})
+
+/* ipqis_empty - 判断索引优先队列是否为空 */
+#define ipqis_empty(Q)      ({ (Q)->count == 0; })
+
+/* ipqsize - 获取索引优先队列元素个数 */
+#define ipqsize(Q)          ({ (Q)->count; })
+
 #endif	// __PQUEUE_H_
@@ -0,0 +1,286 @@
+/***************************************************************
+Copyright © wkangk <wangkangchn@163.com>
+文件名		: pqueue_bench.c
+作者	  	: wkangk <wangkangchn@163.com>
+版本	   	: v1.0
+描述	   	: 优先级队列性能测试
+            函数指针比较(DEFINE_PQUEUE_ELEMENT_TYPE) 与 编译期比较(DEFINE_PQUEUE_ELEMENT_TYPE_CMP)
+            的 push/pop 吞吐量对比, 以及不同元素大小下 2/4/8 叉堆的吞吐量对比,
+            堆远大于缓存时 2/4/8 叉堆的对比;
+            索引优先队列随机 push/decrease_key/pop, 与参考堆(延迟删除)比较弹出的键值并检查位置索引
+时间	   	: 2026-10-18 13:10
+***************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include "tools.h"
+#include "pqueue.h"
+
+/* 函数指针版本 */
+DEFINE_PQUEUE_ELEMENT_TYPE(int, int_pqueue);
+DEFINE_PQUEUE_ELEMENT_TYPE(double, double_pqueue);
+
+int int_compare(const void *arg1, const void *arg2)
+{
+    int __arg1 = *(int *)arg1;
+    int __arg2 = *(int *)arg2;
+    return (__arg1 > __arg2) - (__arg1 < __arg2);
+}
+
+int double_compare(const void *arg1, const void *arg2)
+{
+    double __arg1 = *(double *)arg1;
+    double __arg2 = *(double *)arg2;
+    return (__arg1 > __arg2) - (__arg1 < __arg2);
+}
+
+/* 编译期比较版本 */
+#define int_cmp(a, b)       ( (*(a) > *(b)) - (*(a) < *(b)) )
+#define double_cmp(a, b)    ( (*(a) > *(b)) - (*(a) < *(b)) )
+DEFINE_PQUEUE_ELEMENT_TYPE_CMP(int, int_pqueue_cmp, int_cmp);
+DEFINE_PQUEUE_ELEMENT_TYPE_CMP(double, double_pqueue_cmp, double_cmp);
+
+/* 索引优先队列, 以及作为参考结果的普通优先队列(过期元素在弹出时跳过) */
+DEFINE_IPQUEUE_ELEMENT_TYPE(long, ipqueue);
+typedef struct ref_elem {
+    long key;
+    int id;
+} ref_elem;
+#define ref_cmp(a, b)       ( ((a)->key > (b)->key) - ((a)->key < (b)->key) )
+DEFINE_PQUEUE_ELEMENT_TYPE_CMP(ref_elem, ref_pqueue, ref_cmp);
+
+/* 32 字节元素 */
+typedef struct elem32 {
+    double key;
+    char payload[24];
+} elem32;
+#define elem32_cmp(a, b)    ( ((a)->key > (b)->key) - ((a)->key < (b)->key) )
+DEFINE_PQUEUE_ELEMENT_TYPE_CMP(elem32, elem32_pqueue_cmp, elem32_cmp);
+
+const int N = 1 << 20;
+const int N_LARGE = 1 << 23;       /* double 堆 64MB, 远大于缓存 */
+
+/**
+ * bench - 插入 n 个随机元素后全部弹出, 检查弹出顺序并输出吞吐量
+ * @Q:      优先队列
+ * @push:   插入操作, 调用形式为 push(Q, val)
+ * @pop:    弹出操作, 调用形式为 pop(Q)
+ * @key:    取元素键值, 调用形式为 key(val)
+ * @keys:   待插入元素
+ * @n:      元素个数
+ * @return: 吞吐量(M ops/s)
+ */
+#define bench(Q, push, pop, key, keys, n) ({  \
+    int __i;                            \
+    bool __sorted = true;               \
+    typeof( *(keys) ) __prev, __cur;    \
+    clock_t __start = START();          \
+    for (__i = 0; __i < (n); ++__i)     \
+        push( (Q), (keys)[__i] );       \
+    __prev = pop( (Q) );                \
+    for (__i = 1; __i < (n); ++__i) {   \
+        __cur = pop( (Q) );             \
+        __sorted = __sorted && !(key(__cur) > key(__prev)); \
+        __prev = __cur;                 \
+    }                                   \
+    double __ops = 2.0 * (n) / ((double)(clock() - __start) / CLOCKS_PER_SEC) / 1e6;  \
+    printf("\t%.2f M ops/s%s\n", __ops, __sorted ? "" : " (顺序错误!)");   \
+    __ops;                              \
+})
+
+#define scalar_key(val)     (val)
+#define elem32_key(val)     ((val).key)
+
+/**
+ * straddle - 前 1024 组孩子中, 占用的缓存行比最少所需多一行的比例(跨越缓存行边界)
+ * @Q:      已初始化的优先队列
+ * @return: 百分比
+ */
+#define straddle(Q) ({                                  \
+    size_t __group = sizeof(*(Q)->heap) << (Q)->shift;  \
+    size_t __need = (__group + CACHELINE_SIZE - 1) / CACHELINE_SIZE;    \
+    uintptr_t __first;                                  \
+    int __k, __cross = 0;                               \
+    for (__k = 0; __k < 1024; ++__k) {                  \
+        __first = (uintptr_t)( (Q)->heap + __pqchild(Q, __pqroot(Q) + __k) );   \
+        __cross += (__first + __group - 1) / CACHELINE_SIZE - __first / CACHELINE_SIZE + 1 > __need;   \
+    }                                                   \
+    __cross * 100.0 / 1024;                             \
+})
+
+/**
+ * bench_arity - 分别以 2/4/8 叉堆测试吞吐量, 输出最优叉数
+ * @type:   队列类型
+ * @key:    取元素键值
+ * @keys:   待插入元素
+ * @n:      元素个数
+ */
+#define bench_arity(type, key, keys, n) ({  \
+    unsigned int __d, __best = 0;       \
+    double __rate, __best_rate = 0;     \
+    type *__Q = calloc_buf(1, type);    \
+    for (__d = 2; __d <= 8; __d <<= 1) {\
+        pqinit_dary(__Q, (n), NULL, __d);   \
+        printf("\t%u 叉(孩子跨缓存行 %.0f%%):", __d, straddle(__Q)); \
+        __rate = bench(__Q, type ## _push, type ## _pop, key, (keys), (n)); \
+        if (__rate > __best_rate) {     \
+            __best_rate = __rate;       \
+            __best = __d;               \
+        }                               \
+        pqclear(__Q);                   \
+    }                                   \
+    printf("\t最优: %u 叉\n", __best); \
+    free_buf(__Q);                      \
+})
+
+/**
+ * ipq_check - 检查索引优先队列的堆序与位置索引: pos[heap[k]] == k, 不在队列中的 id 的 pos 为 0
+ * @Q:      索引优先队列
+ * @return: 正确返回 true
+ */
+static bool ipq_check(ipqueue *Q)
+{
+    size_t k, in_queue = 0;
+
+    for (k = __pqroot(Q); k <= __pqlast(Q); ++k) {
+        if (Q->pos[Q->heap[k]] != k)
+            return false;
+        if (k > __pqroot(Q) && int_cmp(Q->keys + Q->heap[__pqparent(Q, k)], Q->keys + Q->heap[k]) < 0)
+            return false;
+    }
+    for (k = 0; k < Q->n; ++k)
+        in_queue += Q->pos[k] != 0;
+    return in_queue == Q->count;
+}
+
+/**
+ * bench_ipq - 随机执行 push/decrease_key/pop, 每次弹出与参考堆比较 id 与键值, 定期检查位置索引
+ *      键值为 随机数 * n + id, 不会相等, 弹出顺序唯一
+ * @d:      堆的叉数
+ * @n:      id 的取值范围
+ * @ops:    操作次数
+ */
+static void bench_ipq(unsigned int d, int n, int ops)
+{
+    ipqueue *Q = calloc_buf(1, ipqueue);
+    ref_pqueue *R = calloc_buf(1, ref_pqueue);
+    long *key = calloc_buf(n, long);
+    int i, id, top, decreases = 0, pops = 0;
+    bool ok = true;
+    ref_elem e;
+    clock_t start;
+
+    ipqinit_dary(Q, n, NULL, d);
+    pqinit(R, n, NULL);
+    start = START();
+    for (i = 0; i < ops && ok; ++i) {
+        id = rand() % n;
+        if (rand() % 3 == 0 && !ipqis_empty(Q)) {
+            /* pop: 参考堆中跳过已被 decrease_key 替换或已弹出的元素 */
+            top = ipqpop_cmp(Q, int_cmp);
+            do {
+                e = ref_pqueue_pop(R);
+            } while (e.key != key[e.id]);
+            ok = top == e.id && ipqkey(Q, top) == e.key;
+            key[top] = -1;
+            ++pops;
+        } else if (ipqcontains(Q, id)) {
+            /* decrease_key: 提高优先级(最大堆中增大键值) */
+            key[id] = ipqkey(Q, id) + (1 + rand() % 1000) * (long)n;
+            ipqdecrease_key_cmp(Q, id, key[id], int_cmp);
+            ref_pqueue_push(R, ((ref_elem){ key[id], id }));
+            ++decreases;
+        } else {
+            key[id] = (rand() % (1 << 20)) * (long)n + id;
+            ipqpush_cmp(Q, id, key[id], int_cmp);
+            ref_pqueue_push(R, ((ref_elem){ key[id], id }));
+        }
+        if (i % 4096 == 0)
+            ok = ok && ipq_check(Q);
+    }
+    ok = ok && ipq_check(Q);
+    printf("\t%u 叉: %d 次操作(decrease_key %d 次, pop %d 次) %.2f M ops/s%s\n", d, i, decreases, pops,
+            i / ((double)(clock() - start) / CLOCKS_PER_SEC) / 1e6, ok ? "" : " (结果错误!)");
+
+    ipqclear(Q);
+    pqclear(R);
+    free_buf(Q);
+    free_buf(R);
+    free_buf(key);
+}
+
+int main(int argc, char *argv[])
+{
+    int i;
+    int *ikeys = calloc_buf(N, int);
+    double *dkeys = calloc_buf(N, double);
+    elem32 *ekeys = calloc_buf(N, elem32);
+    double *lkeys = calloc_buf(N_LARGE, double);
+
+    srand(time(NULL));
+    for (i = 0; i < N; ++i) {
+        ikeys[i] = rand();
+        dkeys[i] = (double)rand() / RAND_MAX;
+        ekeys[i].key = dkeys[i];
+    }
+    for (i = 0; i < N_LARGE; ++i)
+        lkeys[i] = (double)rand() / RAND_MAX;
+
+    int_pqueue *iq = calloc_buf(1, int_pqueue);
+    int_pqueue_cmp *iqc = calloc_buf(1, int_pqueue_cmp);
+    double_pqueue *dq = calloc_buf(1, double_pqueue);
+    double_pqueue_cmp *dqc = calloc_buf(1, double_pqueue_cmp);
+    int_pqueue_cmp *gq = calloc_buf(1, int_pqueue_cmp);
+
+    pqinit(iq, N, int_compare);
+    pqinit(iqc, N, NULL);
+    pqinit(dq, N, double_compare);
+    pqinit(dqc, N, NULL);
+    pqinit(gq, 16, NULL);
+
+    printf("%d 个元素 push + pop\n", N);
+    printf("int 函数指针:\n");
+    bench(iq, pqpush, pqpop, scalar_key, ikeys, N);
+    printf("int 编译期比较:\n");
+    bench(iqc, int_pqueue_cmp_push, int_pqueue_cmp_pop, scalar_key, ikeys, N);
+    printf("int 编译期比较(初始容量 16, 自动扩容):\n");
+    bench(gq, int_pqueue_cmp_push, int_pqueue_cmp_pop, scalar_key, ikeys, N);
+    printf("double 函数指针:\n");
+    bench(dq, pqpush, pqpop, scalar_key, dkeys, N);
+    printf("double 编译期比较:\n");
+    bench(dqc, double_pqueue_cmp_push, double_pqueue_cmp_pop, scalar_key, dkeys, N);
+
+    printf("\n%d 个元素 push + pop, 不同叉数对比\n", N);
+    printf("int(%zu 字节):\n", sizeof(int));
+    bench_arity(int_pqueue_cmp, scalar_key, ikeys, N);
+    printf("double(%zu 字节):\n", sizeof(double));
+    bench_arity(double_pqueue_cmp, scalar_key, dkeys, N);
+    printf("elem32(%zu 字节):\n", sizeof(elem32));
+    bench_arity(elem32_pqueue_cmp, elem32_key, ekeys, N);
+
+    printf("\n%d 个元素 push + pop, 堆大于缓存时不同叉数对比\n", N_LARGE);
+    printf("double(%zu 字节):\n", sizeof(double));
+    bench_arity(double_pqueue_cmp, scalar_key, lkeys, N_LARGE);
+
+    printf("\n索引优先队列(%d 个 id) 随机 push/decrease_key/pop:\n", 1 << 16);
+    for (unsigned int d = 2; d <= 8; d <<= 1)
+        bench_ipq(d, 1 << 16, N);
+
+    pqclear(iq);
+    pqclear(iqc);
+    pqclear(dq);
+    pqclear(dqc);
+    pqclear(gq);
+    free_buf(iq);
+    free_buf(iqc);
+    free_buf(dq);
+    free_buf(dqc);
+    free_buf(gq);
+    free_buf(ikeys);
+    free_buf(dkeys);
+    free_buf(ekeys);
+    free_buf(lkeys);
+    return 0;
+}
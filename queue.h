@@ -13,6 +13,7 @@ Copyright © wkangk <wangkangchn@163.com>
 				其中:
 					max: 队列的最大长度
 				3. xxx_mutex 为带互斥锁操作
+				4. qpush_n/qpop_n 批量入队/出队, 返回实际操作的元素个数
 			e.g.
 				DEFINE_QUEUE_ELEMENT_TYPE(int, queue);
 
@@ -29,7 +30,9 @@ Copyright © wkangk <wangkangchn@163.com>
 #ifndef __WKANGK_QUEUE_H__
 #define __WKANGK_QUEUE_H__
 #include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
+#include "tools.h"
 
 #define DEFINE_QUEUE_ELEMENT_TYPE(type, name)		\
 	typedef struct name {					\
@@ -62,15 +65,15 @@ Copyright © wkangk <wangkangchn@163.com>
 /* pop - 弹出队首元素 */
 #define qpop(Q) ({ 								\
 	typeof(*(Q)->data) __x = (Q)->data[(Q)->head];	\
-    (Q)->head = ++(Q)->head % (Q)->max_length;		\
+    (Q)->head = ((Q)->head + 1) % (Q)->max_length;		\
 	--(Q)->count;									\
 	__x; })
 
 /* push - 向队列中添加元素x */
 #define qpush(Q, x) ({ 						\
-	typeof( *Q->data ) __x = (x);			\
+	typeof( *(Q)->data ) __x = (x);			\
 	(Q)->data[(Q)->tail] = __x; 				\
-	(Q)->tail = ++(Q)->tail % (Q)->max_length;	\
+	(Q)->tail = ((Q)->tail + 1) % (Q)->max_length;	\
 	++(Q)->count;})
 
 /* clear - 清空缓冲区, 释放指针 */
@@ -78,6 +81,40 @@ Copyright © wkangk <wangkangchn@163.com>
 	pthread_mutex_destroy(&( (Q)->mutex ));	\
 	free( (Q)->data ); })
 
+/**
+ * qpush_n - 将数组 src 中的 n 个元素入队, 环形缓冲区回绕时分两次 memcpy
+ * @Q:		队列
+ * @src:	待入队元素数组
+ * @n:		待入队元素个数
+ * @return:	实际入队的元素个数(不超过队列剩余空间)
+ */
+#define qpush_n(Q, src, n) ({										\
+	unsigned int __cnt = min((unsigned int)(n), (Q)->max_length - (Q)->count);	\
+	unsigned int __first = min(__cnt, (Q)->max_length - (Q)->tail);	\
+	memcpy((Q)->data + (Q)->tail, (src), __first * sizeof(*(Q)->data));		\
+	memcpy((Q)->data, (src) + __first, (__cnt - __first) * sizeof(*(Q)->data));	\
+	(Q)->tail += __cnt;												\
+	if ((Q)->tail >= (Q)->max_length)	(Q)->tail -= (Q)->max_length;	\
+	(Q)->count += __cnt;											\
+	__cnt; })
+
+/**
+ * qpop_n - 将至多 n 个队首元素出队到数组 dst, 环形缓冲区回绕时分两次 memcpy
+ * @Q:		队列
+ * @dst:	保存出队元素的数组
+ * @n:		最多出队的元素个数
+ * @return:	实际出队的元素个数
+ */
+#define qpop_n(Q, dst, n) ({										\
+	unsigned int __cnt = min((unsigned int)(n), (Q)->count);		\
+	unsigned int __first = min(__cnt, (Q)->max_length - (Q)->head);	\
+	memcpy((dst), (Q)->data + (Q)->head, __first * sizeof(*(Q)->data));		\
+	memcpy((dst) + __first, (Q)->data, (__cnt - __first) * sizeof(*(Q)->data));	\
+	(Q)->head += __cnt;												\
+	if ((Q)->head >= (Q)->max_length)	(Q)->head -= (Q)->max_length;	\
+	(Q)->count -= __cnt;											\
+	__cnt; })
+
 /* pop_mutex - 弹出队首元素(带互斥锁) */
 #define qpop_mutex(Q) 	({				\
 	pthread_mutex_lock(&(Q)->mutex);		\
@@ -91,4 +128,18 @@ Copyright © wkangk <wangkangchn@163.com>
 	qpush((Q), x);						\
 	pthread_mutex_unlock(&(Q)->mutex);	})
 
+/* push_n_mutex - 批量入队, 只加锁一次(带互斥锁) */
+#define qpush_n_mutex(Q, src, n) ({		\
+	pthread_mutex_lock(&(Q)->mutex);	\
+	unsigned int __ret = qpush_n((Q), (src), (n));	\
+	pthread_mutex_unlock(&(Q)->mutex);	\
+	__ret;	})
+
+/* pop_n_mutex - 批量出队, 只加锁一次(带互斥锁) */
+#define qpop_n_mutex(Q, dst, n) ({		\
+	pthread_mutex_lock(&(Q)->mutex);	\
+	unsigned int __ret = qpop_n((Q), (dst), (n));	\
+	pthread_mutex_unlock(&(Q)->mutex);	\
+	__ret;	})
+
 #endif // !__WKANGK_QUEUE_H__
\ No newline at end of file
@@ -0,0 +1,308 @@
+/***************************************************************
+Copyright © wkangk <wangkangchn@163.com>
+文件名		: queue_bench.c
+作者	  	: wkangk <wangkangchn@163.com>
+版本	   	: v1.0
+描述	   	: 生产者/消费者吞吐量测试
+            queue.h 互斥锁队列(单个/批量) 与 spsc_queue.h 无锁队列(单个/批量)对比,
+            以及 4 生产者/4 消费者时 mpmc_queue.h 的非阻塞, 阻塞, 限时操作
+时间	   	: 2026-10-18 17:20
+***************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include "tools.h"
+#include "queue.h"
+#include "spsc_queue.h"
+#include "mpmc_queue.h"
+
+DEFINE_QUEUE_ELEMENT_TYPE(long, queue);
+DEFINE_SPSC_QUEUE_ELEMENT_TYPE(long, spsc_queue);
+DEFINE_MPMC_QUEUE_ELEMENT_TYPE(long, mpmc_queue);
+
+const long M = 10000000;       /* 消息个数 */
+const int QUEUE_LEN = 1024;
+#define BATCH   64
+#define NPROD   4
+#define NCONS   4
+
+static queue Q;
+static spsc_queue S;
+static mpmc_queue MQ;
+static long sum;
+static long consumed;       /* mpmc 消费者已取出的消息总数 */
+
+/* 墙上时间(秒), clock() 统计的是所有线程的 CPU 时间 */
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* 互斥锁队列: 每个元素加锁一次 */
+static void *mutex_producer(void *arg)
+{
+    long i = 0;
+    bool ok;
+
+    while (i < M) {
+        pthread_mutex_lock(&Q.mutex);
+        if ((ok = !qis_full(&Q)))
+            qpush(&Q, i);
+        pthread_mutex_unlock(&Q.mutex);
+        if (ok)     ++i;
+        else        sched_yield();
+    }
+    return NULL;
+}
+
+static void *mutex_consumer(void *arg)
+{
+    long i = 0;
+    bool ok;
+
+    while (i < M) {
+        pthread_mutex_lock(&Q.mutex);
+        if ((ok = !qis_empty(&Q)))
+            sum += qpop(&Q);
+        pthread_mutex_unlock(&Q.mutex);
+        if (ok)     ++i;
+        else        sched_yield();
+    }
+    return NULL;
+}
+
+/* 互斥锁队列: 每批元素加锁一次 */
+static void *mutex_batch_producer(void *arg)
+{
+    long i = 0, j, buf[BATCH];
+    unsigned int n, done;
+
+    while (i < M) {
+        n = min((long)BATCH, M - i);
+        for (j = 0; j < n; ++j)
+            buf[j] = i + j;
+        for (done = 0; done < n; )
+            if (!(done += qpush_n_mutex(&Q, buf + done, n - done)))
+                sched_yield();
+        i += n;
+    }
+    return NULL;
+}
+
+static void *mutex_batch_consumer(void *arg)
+{
+    long i = 0, j, buf[BATCH];
+    unsigned int n;
+
+    while (i < M) {
+        if ((n = qpop_n_mutex(&Q, buf, BATCH)) == 0) {
+            sched_yield();
+            continue;
+        }
+        for (j = 0; j < n; ++j)
+            sum += buf[j];
+        i += n;
+    }
+    return NULL;
+}
+
+static void *spsc_producer(void *arg)
+{
+    long i = 0;
+
+    while (i < M)
+        if (spsc_push(&S, i))   ++i;
+        else                    sched_yield();
+    return NULL;
+}
+
+static void *spsc_consumer(void *arg)
+{
+    long i = 0, x;
+
+    while (i < M)
+        if (spsc_pop(&S, &x)) {
+            sum += x;
+            ++i;
+        } else
+            sched_yield();
+    return NULL;
+}
+
+static void *spsc_batch_producer(void *arg)
+{
+    long i = 0, j, buf[BATCH];
+    unsigned int n, done;
+
+    while (i < M) {
+        n = min((long)BATCH, M - i);
+        for (j = 0; j < n; ++j)
+            buf[j] = i + j;
+        for (done = 0; done < n; )
+            if (!(done += spsc_push_n(&S, buf + done, n - done)))
+                sched_yield();
+        i += n;
+    }
+    return NULL;
+}
+
+static void *spsc_batch_consumer(void *arg)
+{
+    long i = 0, j, buf[BATCH];
+    unsigned int n;
+
+    while (i < M) {
+        if ((n = spsc_pop_n(&S, buf, BATCH)) == 0) {
+            sched_yield();
+            continue;
+        }
+        for (j = 0; j < n; ++j)
+            sum += buf[j];
+        i += n;
+    }
+    return NULL;
+}
+
+/* mpmc: 生产者 id 发送 [id * M / NPROD, (id + 1) * M / NPROD) */
+static void *mpmc_try_producer(void *arg)
+{
+    long id = (long)arg, i = id * M / NPROD, end = (id + 1) * M / NPROD;
+
+    while (i < end)
+        if (mpmc_try_push(&MQ, i))  ++i;
+        else                        sched_yield();
+    return NULL;
+}
+
+/* 非阻塞消费者: 全部消息取完后退出 */
+static void *mpmc_try_consumer(void *arg)
+{
+    long x, local = 0;
+
+    while (__atomic_load_n(&consumed, __ATOMIC_RELAXED) < M)
+        if (mpmc_try_pop(&MQ, &x)) {
+            local += x;
+            __atomic_add_fetch(&consumed, 1, __ATOMIC_RELAXED);
+        } else
+            sched_yield();
+    __atomic_add_fetch(&sum, local, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+static void *mpmc_producer(void *arg)
+{
+    long id = (long)arg, i = id * M / NPROD, end = (id + 1) * M / NPROD;
+
+    for (; i < end; ++i)
+        mpmc_push(&MQ, i);
+    return NULL;
+}
+
+/* 阻塞消费者: 每个消费者取 M / NCONS 条, 总数与生产者发送的相同, 不会永远阻塞 */
+static void *mpmc_consumer(void *arg)
+{
+    long id = (long)arg, n = (id + 1) * M / NCONS - id * M / NCONS, x, local = 0;
+
+    while (n--) {
+        mpmc_pop(&MQ, &x);
+        local += x;
+    }
+    __atomic_add_fetch(&sum, local, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+/* 限时消费者: 队列空时最多等待 10ms, 全部消息取完后退出 */
+static void *mpmc_timed_consumer(void *arg)
+{
+    long x, local = 0;
+
+    while (__atomic_load_n(&consumed, __ATOMIC_RELAXED) < M)
+        if (mpmc_pop_timed(&MQ, &x, 10)) {
+            local += x;
+            __atomic_add_fetch(&consumed, 1, __ATOMIC_RELAXED);
+        }
+    __atomic_add_fetch(&sum, local, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+/**
+ * bench_mpmc - 运行 NPROD 个生产者与 NCONS 个消费者线程, 输出每秒消息数并校验消息总和
+ * @name:       测试名称
+ * @producer:   生产者线程函数, 参数为线程编号
+ * @consumer:   消费者线程函数, 参数为线程编号
+ */
+static void bench_mpmc(const char *name, void *(*producer)(void *), void *(*consumer)(void *))
+{
+    pthread_t p[NPROD], c[NCONS];
+    double start;
+    long i;
+
+    sum = consumed = 0;
+    start = now();
+    for (i = 0; i < NPROD; ++i)
+        pthread_create(p + i, NULL, producer, (void *)i);
+    for (i = 0; i < NCONS; ++i)
+        pthread_create(c + i, NULL, consumer, (void *)i);
+    for (i = 0; i < NPROD; ++i)
+        pthread_join(p[i], NULL);
+    for (i = 0; i < NCONS; ++i)
+        pthread_join(c[i], NULL);
+    printf("%-12s %8.2f M msgs/s%s\n", name, M / (now() - start) / 1e6,
+            sum == M * (M - 1) / 2 && mpmc_size(&MQ) == 0 ? "" : " (校验错误!)");
+}
+
+/**
+ * bench - 运行一对生产者/消费者线程, 输出每秒消息数并校验消息总和
+ * @name:       测试名称
+ * @producer:   生产者线程函数
+ * @consumer:   消费者线程函数
+ */
+static void bench(const char *name, void *(*producer)(void *), void *(*consumer)(void *))
+{
+    pthread_t p, c;
+    double start;
+
+    sum = 0;
+    start = now();
+    pthread_create(&p, NULL, producer, NULL);
+    pthread_create(&c, NULL, consumer, NULL);
+    pthread_join(p, NULL);
+    pthread_join(c, NULL);
+    printf("%-12s %8.2f M msgs/s%s\n", name, M / (now() - start) / 1e6,
+            sum == M * (M - 1) / 2 ? "" : " (校验错误!)");
+}
+
+int main(int argc, char *argv[])
+{
+    qinit(&Q, QUEUE_LEN);
+    spsc_init(&S, QUEUE_LEN);
+
+    printf("%ld 条消息, 队列长度 %d\n", M, QUEUE_LEN);
+    bench("mutex", mutex_producer, mutex_consumer);
+    bench("mutex batch", mutex_batch_producer, mutex_batch_consumer);
+    bench("spsc", spsc_producer, spsc_consumer);
+    bench("spsc batch", spsc_batch_producer, spsc_batch_consumer);
+
+    long x;
+    double start;
+    mpmc_init(&MQ, QUEUE_LEN);
+    printf("%d 个生产者, %d 个消费者\n", NPROD, NCONS);
+    bench_mpmc("mpmc try", mpmc_try_producer, mpmc_try_consumer);
+    bench_mpmc("mpmc", mpmc_producer, mpmc_consumer);
+    bench_mpmc("mpmc timed", mpmc_producer, mpmc_timed_consumer);
+    bool got = mpmc_try_pop(&MQ, &x), timed;
+    start = now();
+    timed = mpmc_pop_timed(&MQ, &x, 100);
+    printf("空队列 mpmc_try_pop: %s, mpmc_pop_timed(100ms): %s, 等待 %.0f ms\n",
+            got ? "成功(错误!)" : "失败", timed ? "成功(错误!)" : "超时", (now() - start) * 1e3);
+
+    qclear(&Q);
+    spsc_clear(&S);
+    mpmc_clear(&MQ);
+    return 0;
+}
@@ -0,0 +1,392 @@
+/***************************************************************
+Copyright © wkangk <wangkangchn@163.com>
+文件名		: shortest_path.h
+作者	  	: wkangk <wangkangchn@163.com>
+版本	   	: v1.0
+描述	   	: 单源最短路径(Dijkstra)与 A* 搜索, 邻接矩阵上的全源最短路径(分块 Floyd–Warshall), 边权不能为负
+			优先队列使用 pqueue.h 的索引优先队列(4 叉最小堆), 距离与堆保存在 sp_search 中,
+			初始化后可反复查询, 每次查询只重置上一次访问过的顶点, 不再分配内存.
+			邻接表(_Vertex_)与 CSR 图(csr_graph)使用相同的接口, CSR 图的函数以 csr_ 开头.
+			使用方法:
+				1. sp_search_init(S, n) 为 n 个顶点的图分配缓冲区
+				2. dijkstra(G, S, s)			单源, 求出 s 到全部顶点的距离
+				   dijkstra_to(G, S, s, t)		点到点, t 出队后立即返回
+				   astar(G, S, s, t, h, arg)	点到点, h(v, t, arg) 为 v 到 t 距离的下界
+				   dijkstra_batch(G, S, sources, k, dist)		k 个起点的单源距离
+				   dijkstra_pairs(G, S, sources, targets, k, dist)	k 个点到点距离
+				3. S->dist[v] 为距离, 不可达为 SP_INFTY, sp_path(S, t, path) 得到路径
+				4. sp_search_free(S) 释放缓冲区
+				5. floyd_warshall(matrix, n, nthreads) 在 list2matrix 得到的邻接矩阵上原地计算全源最短路径
+			e.g.
+				sp_search S;
+				sp_search_init(&S, n);
+				long d = dijkstra_to(G, &S, 0, n - 1);
+				int len = sp_path(&S, n - 1, path);
+				sp_search_free(&S);
+时间	   	: 2026-10-19 05:20
+***************************************************************/
+#ifndef __WKANGK_SHORTEST_PATH_H__
+#define __WKANGK_SHORTEST_PATH_H__
+#include <limits.h>
+#include <stdbool.h>
+#include "tools.h"
+#include "graph.h"
+#include "pqueue.h"
+
+/* 不可达顶点的距离 */
+#define SP_INFTY        LONG_MAX
+
+/* A* 启发函数, 返回 v 到 t 距离的下界(不能高估, 否则结果不一定最短) */
+typedef long (*sp_heuristic_fn)(int v, int t, void *arg);
+
+DEFINE_IPQUEUE_ELEMENT_TYPE(long, __sp_ipqueue);
+
+/* 键值小的优先 */
+#define __sp_cmp(a, b)      ( (*(b) > *(a)) - (*(b) < *(a)) )
+
+/*
+ * @count:      本次查询访问的顶点个数
+ * @dist:       到起点的距离, 未访问为 SP_INFTY
+ * @parent:     最短路径树中的父顶点, 起点与未访问顶点为 -1
+ * @h:          A* 中各顶点的启发函数值, 每个顶点只计算一次
+ * @visited:    本次查询访问的顶点, 下次查询前只重置这些顶点
+ * @heap:       键值为 dist + h
+ */
+typedef struct sp_search {
+    int n;
+    int count;
+    long *dist;
+    int *parent;
+    long *h;
+    int *visited;
+    __sp_ipqueue heap;
+} sp_search;
+
+/**
+ * sp_search_init - 为 n 个顶点的图分配查询缓冲区
+ * @S:      查询缓冲区
+ * @n:      图中顶点个数
+ * @return: 无
+ */
+static inline void sp_search_init(sp_search *S, int n)
+{
+    S->n = n;
+    S->count = 0;
+    S->dist = calloc_buf(n, long);
+    S->parent = calloc_buf(n, int);
+    S->h = calloc_buf(n, long);
+    S->visited = calloc_buf(n, int);
+    for (int v = 0; v < n; ++v) {
+        S->dist[v] = SP_INFTY;
+        S->parent[v] = -1;
+    }
+    ipqinit_dary(&S->heap, n, NULL, 4);
+}
+
+/* sp_search_free - 释放查询缓冲区 */
+static inline void sp_search_free(sp_search *S)
+{
+    free_buf(S->dist);
+    free_buf(S->parent);
+    free_buf(S->h);
+    free_buf(S->visited);
+    ipqclear(&S->heap);
+    S->n = S->count = 0;
+}
+
+/* __sp_reset - 只重置上一次查询访问过的顶点, 点到点查询提前返回时堆中可能还有元素 */
+static inline void __sp_reset(sp_search *S)
+{
+    for (int i = 0; i < S->count; ++i) {
+        S->dist[S->visited[i]] = SP_INFTY;
+        S->parent[S->visited[i]] = -1;
+    }
+    S->count = 0;
+    ipqreset(&S->heap);
+}
+
+/**
+ * __sp_relax - 经边 (u, v) 到达 v 的距离为 d, 比已知距离短时更新
+ * @return: 无
+ */
+static inline void __sp_relax(sp_search *S, int u, int v, long d, int t,
+                                sp_heuristic_fn h, void *arg)
+{
+    if (d >= S->dist[v])
+        return;
+    if (S->dist[v] == SP_INFTY) {
+        S->visited[S->count++] = v;
+        S->h[v] = h ? h(v, t, arg) : 0;
+    }
+    S->dist[v] = d;
+    S->parent[v] = u;
+    /* 启发函数不满足一致性时已出队的顶点可能再次入队 */
+    if (ipqcontains(&S->heap, v))
+        ipqdecrease_key_cmp(&S->heap, v, d + S->h[v], __sp_cmp);
+    else
+        ipqpush_cmp(&S->heap, v, d + S->h[v], __sp_cmp);
+}
+
+/* 遍历邻接表中 u 的出边, v 与 w 为边的终点与权 */
+#define __sp_list_for_each_edge(G, u, v, w)                         \
+    for (struct list_head *__p = (G)[(u)].list.next;                \
+            __p != &(G)[(u)].list                                   \
+            && ((v) = list_entry(__p, _adj_node_, list)->id,        \
+                (w) = list_entry(__p, _adj_node_, list)->w, 1);     \
+            __p = __p->next)
+
+/* 遍历 CSR 图中 u 的出边, v 与 w 为边的终点与权 */
+#define __sp_csr_for_each_edge(C, u, v, w)                          \
+    for (long __e = (C)->offsets[(u)];                              \
+            __e < (C)->offsets[(u) + 1]                             \
+            && ((v) = (C)->targets[__e], (w) = (C)->weights[__e], 1);   \
+            ++__e)
+
+/**
+ * __DEFINE_SP_SEARCH - 为一种图的表示生成查询函数
+ * @prefix:         函数名前缀
+ * @graph_type:     图的类型
+ * @for_each_edge:  遍历出边的宏, 调用形式为 for_each_edge(G, u, v, w)
+ */
+#define __DEFINE_SP_SEARCH(prefix, graph_type, for_each_edge)                           \
+/* t < 0 时求出 s 到全部顶点的距离, 否则 t 出队后立即返回 */                               \
+static inline void __##prefix##sp_run(graph_type G, sp_search *S, int s, int t,          \
+                                        sp_heuristic_fn h, void *arg)                   \
+{                                                                                       \
+    int u, v, w;                                                                        \
+                                                                                        \
+    assert(s >= 0 && s < S->n && t < S->n);                                             \
+    __sp_reset(S);                                                                      \
+    __sp_relax(S, -1, s, 0, t, h, arg);                                                 \
+    while (!ipqis_empty(&S->heap)) {                                                    \
+        u = ipqpop_cmp(&S->heap, __sp_cmp);                                             \
+        if (u == t)                                                                     \
+            return;                                                                     \
+        for_each_edge(G, u, v, w)                                                       \
+            __sp_relax(S, u, v, S->dist[u] + w, t, h, arg);                             \
+    }                                                                                   \
+}                                                                                       \
+                                                                                        \
+/* prefix##dijkstra - 单源最短路径, 返回可达顶点个数 */                                     \
+static inline int prefix##dijkstra(graph_type G, sp_search *S, int s)                   \
+{                                                                                       \
+    __##prefix##sp_run(G, S, s, -1, NULL, NULL);                                        \
+    return S->count;                                                                    \
+}                                                                                       \
+                                                                                        \
+/* prefix##dijkstra_to - s 到 t 的最短距离, 不可达返回 SP_INFTY */                         \
+static inline long prefix##dijkstra_to(graph_type G, sp_search *S, int s, int t)       \
+{                                                                                       \
+    __##prefix##sp_run(G, S, s, t, NULL, NULL);                                         \
+    return S->dist[t];                                                                  \
+}                                                                                       \
+                                                                                        \
+/* prefix##astar - A* 搜索 s 到 t 的最短距离, 不可达返回 SP_INFTY */                       \
+static inline long prefix##astar(graph_type G, sp_search *S, int s, int t,             \
+                                    sp_heuristic_fn h, void *arg)                       \
+{                                                                                       \
+    __##prefix##sp_run(G, S, s, t, h, arg);                                             \
+    return S->dist[t];                                                                  \
+}                                                                                       \
+                                                                                        \
+/* prefix##dijkstra_batch - k 个起点的单源最短路径, dist 为 k * n 的矩阵, 第 i 行对应 sources[i] */  \
+static inline void prefix##dijkstra_batch(graph_type G, sp_search *S, const int *sources,   \
+                                            int k, long *dist)                          \
+{                                                                                       \
+    for (int i = 0; i < k; ++i) {                                                       \
+        __##prefix##sp_run(G, S, sources[i], -1, NULL, NULL);                           \
+        memcpy(dist + (long)i * S->n, S->dist, S->n * sizeof(long));                    \
+    }                                                                                   \
+}                                                                                       \
+                                                                                        \
+/* prefix##dijkstra_pairs - k 个点到点查询, dist[i] 为 sources[i] 到 targets[i] 的距离 */   \
+static inline void prefix##dijkstra_pairs(graph_type G, sp_search *S, const int *sources,   \
+                                            const int *targets, int k, long *dist)      \
+{                                                                                       \
+    for (int i = 0; i < k; ++i)                                                         \
+        dist[i] = prefix##dijkstra_to(G, S, sources[i], targets[i]);                    \
+}
+
+__DEFINE_SP_SEARCH(, _Vertex_ *, __sp_list_for_each_edge)
+__DEFINE_SP_SEARCH(csr_, const csr_graph *, __sp_csr_for_each_edge)
+
+/**
+ * sp_path - 由最近一次查询的结果得到从起点到 t 的路径
+ * @S:      查询缓冲区
+ * @t:      终点
+ * @path:   保存路径(起点在前), 长度至少为路径上的顶点个数, 不超过 n
+ * @return: 路径上的顶点个数, t 不可达返回 0
+ */
+static inline int sp_path(const sp_search *S, int t, int *path)
+{
+    int len = 0, i;
+
+    if (S->dist[t] == SP_INFTY)
+        return 0;
+    for (; t != -1; t = S->parent[t])
+        path[len++] = t;
+    for (i = 0; i < len / 2; ++i)
+        swap(path + i, path + len - 1 - i);
+    return len;
+}
+
+/*
+            Floyd–Warshall 全源最短路径
+    直接在 list2matrix 得到的 n * n 邻接矩阵上计算, 计算后 matrix[i][j] 为 i 到 j 的最短距离,
+    不可达仍为 WEIGHT_INFTY. 路径长度需小于 WEIGHT_INFTY, 两个 WEIGHT_INFTY 相加不会溢出.
+    矩阵按 FW_BLOCK * FW_BLOCK 分块, 对第 kb 个块行/块列:
+        1. 更新对角块 (kb, kb)
+        2. 用对角块更新第 kb 行与第 kb 列的块
+        3. 用第 kb 列与第 kb 行的块更新其余全部块
+    每个块只需在缓存中保留 3 个块, 第 2, 3 步中各块互相独立, 由多个线程分别计算.
+    块内最内层循环为连续的 min(c, a + b), 使用 GCC 向量扩展一次计算 4 或 8 个元素.
+e.g.
+int matrix[n][n];
+list2matrix(G, n, (int **)matrix);
+floyd_warshall((int **)matrix, n, 4);
+ */
+#define FW_BLOCK        64
+
+/* GCC 向量扩展, 使用 -mavx2 编译时一次计算 8 个 int, 否则为 SSE2/NEON 的 4 个 int */
+#ifdef __AVX2__
+typedef int __fw_vec __attribute__((vector_size(32)));
+#else
+typedef int __fw_vec __attribute__((vector_size(16)));
+#endif
+#define __FW_VEC        (int)(sizeof(__fw_vec) / sizeof(int))
+
+/* __fw_min_add - c[j] = min(c[j], a + b[j]), j < cols */
+static inline void __fw_min_add(int *c, int a, const int *b, int cols)
+{
+    __fw_vec va = a - (__fw_vec){0}, vb, vc, vt, m;
+    int j = 0, t;
+
+    for (; j + __FW_VEC <= cols; j += __FW_VEC) {
+        memcpy(&vb, b + j, sizeof(vb));
+        memcpy(&vc, c + j, sizeof(vc));
+        vt = va + vb;
+        m = vt < vc;
+        vc = (vt & m) | (vc & ~m);
+        memcpy(c + j, &vc, sizeof(vc));
+    }
+    for (; j < cols; ++j) {
+        t = a + b[j];
+        c[j] = t < c[j] ? t : c[j];
+    }
+}
+
+/**
+ * __fw_block - c[i][j] = min(c[i][j], a[i][k] + b[k][j]), 三个块的行间距均为 n
+ *      Note:
+ *          c 可以与 a 或 b 是同一个块: 对角线为 0, 第 k 次迭代中第 k 行与第 k 列不会改变
+ * @rows, cols: c 的行数, 列数
+ * @depth:      a 的列数(b 的行数)
+ */
+static inline void __fw_block(int *c, const int *a, const int *b, long n,
+                                int rows, int cols, int depth)
+{
+    int i, k, aik;
+
+    for (k = 0; k < depth; ++k)
+        for (i = 0; i < rows; ++i)
+            if ((aik = a[i * n + k]) < WEIGHT_INFTY)
+                __fw_min_add(c + i * n, aik, b + k * n, cols);
+}
+
+struct __fw_team {
+    int *d;
+    long n;
+    int nblocks;
+    int nthreads;
+    pthread_barrier_t barrier;
+};
+
+struct __fw_arg {
+    struct __fw_team *team;
+    int id;
+};
+
+/* __fw_tile - 第 ib 行第 jb 列的块的首地址与大小 */
+#define __fw_tile(T, ib, jb)    ( (T)->d + (long)(ib) * FW_BLOCK * (T)->n + (long)(jb) * FW_BLOCK )
+#define __fw_size(T, b)         ( (int)min((T)->n - (long)(b) * FW_BLOCK, (long)FW_BLOCK) )
+
+static inline void *__fw_worker(void *arg)
+{
+    struct __fw_team *T = ((struct __fw_arg *)arg)->team;
+    int id = ((struct __fw_arg *)arg)->id;
+    int nb = T->nblocks, kb, ib, jb, kd, x;
+    int *kk;
+
+    for (kb = 0; kb < nb; ++kb) {
+        kk = __fw_tile(T, kb, kb);
+        kd = __fw_size(T, kb);
+        if (id == 0)
+            __fw_block(kk, kk, kk, T->n, kd, kd, kd);
+        pthread_barrier_wait(&T->barrier);
+
+        /* 第 kb 行与第 kb 列, 共 2 * nb 个块(跳过对角块) */
+        for (x = id; x < 2 * nb; x += T->nthreads) {
+            if ((ib = x >> 1) == kb)
+                continue;
+            if (x & 1)
+                __fw_block(__fw_tile(T, ib, kb), __fw_tile(T, ib, kb), kk, T->n,
+                            __fw_size(T, ib), kd, kd);
+            else
+                __fw_block(__fw_tile(T, kb, ib), kk, __fw_tile(T, kb, ib), T->n,
+                            kd, __fw_size(T, ib), kd);
+        }
+        pthread_barrier_wait(&T->barrier);
+
+        /* 其余块 */
+        for (x = id; x < nb * nb; x += T->nthreads) {
+            ib = x / nb;
+            jb = x % nb;
+            if (ib == kb || jb == kb)
+                continue;
+            __fw_block(__fw_tile(T, ib, jb), __fw_tile(T, ib, kb), __fw_tile(T, kb, jb), T->n,
+                        __fw_size(T, ib), __fw_size(T, jb), kd);
+        }
+        pthread_barrier_wait(&T->barrier);
+    }
+    return NULL;
+}
+
+static inline void __floyd_warshall(int *d, int n, int nthreads)
+{
+    struct __fw_team team = { .d = d, .n = n, .nblocks = (n + FW_BLOCK - 1) / FW_BLOCK };
+    struct __fw_arg *args;
+    pthread_t *threads;
+    int i;
+
+    if (n <= 0)
+        return;
+    /* 每个线程至少分到一个块 */
+    team.nthreads = max(min(nthreads, team.nblocks * team.nblocks), 1);
+    args = calloc_buf(team.nthreads, struct __fw_arg);
+    threads = calloc_buf(team.nthreads, pthread_t);
+    pthread_barrier_init(&team.barrier, NULL, team.nthreads);
+    for (i = 0; i < team.nthreads; ++i) {
+        args[i].team = &team;
+        args[i].id = i;
+        if (i)
+            pthread_create(threads + i, NULL, __fw_worker, args + i);
+    }
+    __fw_worker(args);
+    for (i = 1; i < team.nthreads; ++i)
+        pthread_join(threads[i], NULL);
+
+    pthread_barrier_destroy(&team.barrier);
+    free_buf(args);
+    free_buf(threads);
+}
+
+/**
+ * floyd_warshall - 分块 Floyd–Warshall, 在邻接矩阵上原地计算全源最短路径
+ * @matrix:     邻接矩阵(int **, 实际为连续的 n * n 个 int), 对角线为 0, 没有边为 WEIGHT_INFTY
+ * @n:          图中顶点个数
+ * @nthreads:   线程数
+ * @return:     无
+ */
+#define floyd_warshall(matrix, n, nthreads)     ({ __floyd_warshall( (int *)(matrix), (n), (nthreads) ); })
+
+#endif // !__WKANGK_SHORTEST_PATH_H__
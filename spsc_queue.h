@@ -0,0 +1,173 @@
+/***************************************************************
+Copyright © wkangk <wangkangchn@163.com>
+文件名		: spsc_queue.h
+作者	  	: wkangk <wangkangchn@163.com>
+版本	   	: v1.0
+描述	   	: 单生产者单消费者无锁环形队列
+			只允许一个线程 push, 一个线程 pop. head 只由消费者写, tail 只由生产者写,
+			二者使用 acquire/release 原子操作同步, 并分别位于不同的缓存行.
+			队列长度为 2 的幂, 下标使用掩码取模.
+			使用方法:
+				1. 使用 DEFINE_SPSC_QUEUE_ELEMENT_TYPE(type, name) 定义使用的队列元素类型
+				其中:
+					type: 指定队列数组类型
+					name: 结构体名称
+				2. 使用 spsc_init(Q, max) 来初始化队列结构体元素
+				其中:
+					max: 队列的最大长度, 向上取整为 2 的幂
+				3. spsc_push/spsc_pop 队列满/空时立即返回 false,
+				spsc_push_n/spsc_pop_n 批量操作, 返回实际操作的元素个数
+			e.g.
+				DEFINE_SPSC_QUEUE_ELEMENT_TYPE(int, spsc_queue);
+
+				spsc_queue *Q = calloc(1, sizeof(spsc_queue));
+				spsc_init(Q, 1024);
+
+				生产者:	while (!spsc_push(Q, x)) ;
+				消费者:	while (!spsc_pop(Q, &x)) ;
+
+				spsc_clear(Q);
+				free(Q);
+时间	   	: 2026-10-18 17:20
+***************************************************************/
+#ifndef __WKANGK_SPSC_QUEUE_H__
+#define __WKANGK_SPSC_QUEUE_H__
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "tools.h"
+
+/*
+ * @head:		消费者读取位置(只由消费者写)
+ * @tail_cache:	消费者缓存的 tail, 减少对生产者缓存行的访问
+ * @tail:		生产者写入位置(只由生产者写)
+ * @head_cache:	生产者缓存的 head
+ * @mask:		队列长度 - 1
+ */
+#define DEFINE_SPSC_QUEUE_ELEMENT_TYPE(type, name)		\
+	typedef struct name {							\
+		unsigned int head __cacheline_aligned;		\
+		unsigned int tail_cache;					\
+		unsigned int tail __cacheline_aligned;		\
+		unsigned int head_cache;					\
+		unsigned int mask __cacheline_aligned;		\
+		type *data;									\
+	} name
+
+/* 成功返回1, 失败返回0 */
+#define spsc_init(Q, max) ({									\
+		(Q)->mask = roundup_pow_of_two(max) - 1;				\
+		(Q)->head = (Q)->tail = 0;								\
+		(Q)->head_cache = (Q)->tail_cache = 0;					\
+		(Q)->data = calloc((Q)->mask + 1, sizeof(*(Q)->data));	\
+		(Q)->data != NULL;	})
+
+/* spsc_size - 获取队列长度(仅作参考, 读取期间可能被另一端修改) */
+#define spsc_size(Q)		({	\
+	__atomic_load_n(&(Q)->tail, __ATOMIC_ACQUIRE) - __atomic_load_n(&(Q)->head, __ATOMIC_ACQUIRE); })
+
+/* spsc_is_empty - 判断队列是否为空 */
+#define spsc_is_empty(Q)	({ spsc_size(Q) == 0; })
+
+/**
+ * spsc_push - 生产者入队
+ * @Q:		队列
+ * @x:		待入队元素
+ * @return:	成功返回 true, 队列满返回 false
+ */
+#define spsc_push(Q, x)	({											\
+	bool __ok = true;												\
+	unsigned int __t = (Q)->tail;									\
+	if (__t - (Q)->head_cache > (Q)->mask) {						\
+		(Q)->head_cache = __atomic_load_n(&(Q)->head, __ATOMIC_ACQUIRE);	\
+		__ok = __t - (Q)->head_cache <= (Q)->mask;					\
+	}																\
+	if (__ok) {														\
+		(Q)->data[__t & (Q)->mask] = (x);							\
+		__atomic_store_n(&(Q)->tail, __t + 1, __ATOMIC_RELEASE);	\
+	}																\
+	__ok; })
+
+/**
+ * spsc_pop - 消费者出队
+ * @Q:		队列
+ * @px:		保存出队元素的地址
+ * @return:	成功返回 true, 队列空返回 false
+ */
+#define spsc_pop(Q, px)	({											\
+	bool __ok = true;												\
+	unsigned int __h = (Q)->head;									\
+	if (__h == (Q)->tail_cache) {									\
+		(Q)->tail_cache = __atomic_load_n(&(Q)->tail, __ATOMIC_ACQUIRE);	\
+		__ok = __h != (Q)->tail_cache;								\
+	}																\
+	if (__ok) {														\
+		*(px) = (Q)->data[__h & (Q)->mask];							\
+		__atomic_store_n(&(Q)->head, __h + 1, __ATOMIC_RELEASE);	\
+	}																\
+	__ok; })
+
+/**
+ * __spsc_copy_in - 将连续数组中的 n 个元素复制到环形缓冲区, 最多两次 memcpy
+ * @Q:		队列
+ * @pos:	环形缓冲区起始位置(未取模)
+ * @src:	连续数组
+ * @n:		元素个数
+ */
+#define __spsc_copy_in(Q, pos, src, n) ({							\
+	unsigned int __off = (pos) & (Q)->mask;							\
+	unsigned int __first = min((unsigned int)(n), (Q)->mask + 1 - __off);	\
+	memcpy((Q)->data + __off, (src), __first * sizeof(*(Q)->data));	\
+	memcpy((Q)->data, (src) + __first, ((n) - __first) * sizeof(*(Q)->data));	})
+
+/**
+ * __spsc_copy_out - 将环形缓冲区中的 n 个元素复制到连续数组, 最多两次 memcpy
+ * @Q:		队列
+ * @pos:	环形缓冲区起始位置(未取模)
+ * @dst:	连续数组
+ * @n:		元素个数
+ */
+#define __spsc_copy_out(Q, pos, dst, n) ({							\
+	unsigned int __off = (pos) & (Q)->mask;							\
+	unsigned int __first = min((unsigned int)(n), (Q)->mask + 1 - __off);	\
+	memcpy((dst), (Q)->data + __off, __first * sizeof(*(Q)->data));	\
+	memcpy((dst) + __first, (Q)->data, ((n) - __first) * sizeof(*(Q)->data));	})
+
+/**
+ * spsc_push_n - 生产者批量入队
+ * @Q:		队列
+ * @src:	待入队元素数组
+ * @n:		待入队元素个数
+ * @return:	实际入队的元素个数
+ */
+#define spsc_push_n(Q, src, n)	({									\
+	unsigned int __t = (Q)->tail;									\
+	unsigned int __cnt = (n);										\
+	if (__t - (Q)->head_cache + __cnt > (Q)->mask + 1)				\
+		(Q)->head_cache = __atomic_load_n(&(Q)->head, __ATOMIC_ACQUIRE);	\
+	__cnt = min(__cnt, (Q)->mask + 1 - (__t - (Q)->head_cache));	\
+	__spsc_copy_in(Q, __t, (src), __cnt);						\
+	__atomic_store_n(&(Q)->tail, __t + __cnt, __ATOMIC_RELEASE);	\
+	__cnt; })
+
+/**
+ * spsc_pop_n - 消费者批量出队
+ * @Q:		队列
+ * @dst:	保存出队元素的数组
+ * @n:		最多出队的元素个数
+ * @return:	实际出队的元素个数
+ */
+#define spsc_pop_n(Q, dst, n)	({									\
+	unsigned int __h = (Q)->head;									\
+	unsigned int __cnt = (n);										\
+	if ((Q)->tail_cache - __h < __cnt)								\
+		(Q)->tail_cache = __atomic_load_n(&(Q)->tail, __ATOMIC_ACQUIRE);	\
+	__cnt = min(__cnt, (Q)->tail_cache - __h);						\
+	__spsc_copy_out(Q, __h, (dst), __cnt);						\
+	__atomic_store_n(&(Q)->head, __h + __cnt, __ATOMIC_RELEASE);	\
+	__cnt; })
+
+/* spsc_clear - 释放缓冲区 */
+#define spsc_clear(Q)		({ free( (Q)->data ); })
+
+#endif // !__WKANGK_SPSC_QUEUE_H__
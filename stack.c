@@ -1,34 +1,108 @@
+/***************************************************************
+Copyright © wkangk <wangkangchn@163.com>
+文件名		: stack.c
+作者	  	: wkangk <wangkangchn@163.com>
+版本	   	: v1.0
+描述	   	: stack.h 使用示例
+            1. sreserve/spush_n/spop/sshrink_to_fit 后检查栈长度与容量
+            2. 逆波兰表达式求值
+            e.g.
+                输入: 1 2 + 3 4 - * #
+                输出: -3
+时间	   	: 2020-08-23 17:16
+***************************************************************/
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
 #include "stack.h"
-DEFINE_ELEMENT_TYPE(int, stack);
+DEFINE_STACK_ELEMENT_TYPE(int, stack);
 
-int MAX;
+/* 初始容量, 栈满时自动扩容 */
+const int MAX = 4;
+
+/**
+ * check - 检查栈长度与容量, 不符时输出错误
+ * @step:	步骤名称
+ * @len:	期望的栈长度
+ * @cap:	期望的容量
+ */
+static void check(struct stack *S, const char *step, int len, unsigned int cap)
+{
+    printf("%-16s 长度 %3d, 容量 %3u%s\n", step, ssize(S), S->max_length,
+            ssize(S) == len && S->max_length == cap ? "" : " (错误!)");
+}
+
+/* capacity_demo - 预留, 批量入栈, 出栈, 释放多余空间 */
+static void capacity_demo(void)
+{
+    struct stack S;
+    int src[100], i, ok = 1;
+
+    for (i = 0; i < 100; ++i)
+        src[i] = i;
+    sinit(&S, MAX);
+    check(&S, "sinit", 0, MAX);
+
+    sreserve(&S, 64);
+    check(&S, "sreserve 64", 0, 64);
+    sreserve(&S, 16);               /* 容量足够, 不缩小 */
+    check(&S, "sreserve 16", 0, 64);
+
+    spush_n(&S, src, 50);
+    check(&S, "spush_n 50", 50, 64);
+    spush_n(&S, src + 50, 50);      /* 超出容量, 按 2 倍扩容 */
+    check(&S, "spush_n 50", 100, 128);
+
+    for (i = 99; i >= 90; --i)      /* src[n - 1] 位于栈顶 */
+        ok &= spop(&S) == i;
+    check(&S, "spop 10", 90, 128);
+    if (!ok)
+        printf("出栈顺序错误!\n");
+
+    sshrink_to_fit(&S);
+    check(&S, "sshrink_to_fit", 90, 90);
+    for (i = 0; i < 90; ++i)        /* 缩容后数据保持不变 */
+        ok &= S.data[i] == i;
+    spush(&S, 90);
+    check(&S, "spush", 91, 180);
+
+    while (!sis_empty(&S))
+        spop(&S);
+    sshrink_to_fit(&S);             /* 空栈至少保留 1 个元素的空间 */
+    check(&S, "sshrink_to_fit", 0, 1);
+    printf("数据%s\n", ok ? "正确" : "错误!");
+    sclear(&S);
+}
 
 int main(int argc, char *argv[])
 {
     char s[100];
+    capacity_demo();
+
     struct stack *S = calloc(1, sizeof(struct stack));
-    printf("%d\n", init(S, MAX));
-    int a ,b ;
+    printf("%d\n", sinit(S, MAX));
+    int a, b;
 
     while (scanf("%s", s) != EOF) { /* linux 中 scanf 是自己抛弃换行啊 */
         switch (s[0])
         {
         case '+':
-            push(S, pop(S) + pop(S));
+            b = spop(S);
+            a = spop(S);
+            spush(S, a + b);
             break;
         
         case '-':
-            // a = pop(S);
-            // b = pop(S); 
-            push(S, - pop(S) + pop(S));
+            b = spop(S);
+            a = spop(S);
+            spush(S, a - b);
             break;
         
         case '*':
-            push(S, pop(S) * pop(S));
+            b = spop(S);
+            a = spop(S);
+            spush(S, a * b);
             break;
 
         case '#':
@@ -36,14 +110,14 @@ int main(int argc, char *argv[])
             break;
 
         default:
-            push(S, atoi(s));
+            spush(S, atoi(s));
             break;
         }
         
     }
 lab_ret:
-    printf("%d\n", pop(S));
-    clear(S);
+    printf("%d\n", spop(S));
+    sclear(S);
     free(S);
     return 0;
-}
\ No newline at end of file
+}
@@ -9,10 +9,12 @@ Copyright © wkangk <wangkangchn@163.com>
 				其中:
 					type: 指定栈数组类型
 					name: 结构体名称
-				2. 使用 init(Q, max) 来初始化栈结构体元素
+				2. 使用 sinit(S, len) 来初始化栈结构体元素
 				其中:
-					max: 栈的最大长度
-				3. xxx_mutex 为带互斥锁操作
+					len: 栈的初始容量, 入栈超过容量时自动按 2 倍扩容
+				3. xxx_mutex 为带互斥锁操作, 多线程频繁入栈出栈时可使用 lfstack.h 中的无锁栈
+				4. sreserve(S, n) 预留可容纳 n 个元素的空间, sshrink_to_fit(S) 释放多余空间,
+				spush_n(S, src, n) 将数组整体入栈
 			e.g.
 				DEFINE_STACK_ELEMENT_TYPE(int, stack);
 
@@ -21,7 +23,7 @@ Copyright © wkangk <wangkangchn@163.com>
 				int main(int argc, char *argv[])
 				{
 					struct stack *S = calloc(1, sizeof(struct stack));
-					printf("%d\n", init(S, MAX));
+					printf("%d\n", sinit(S, MAX));
 					return 0;
 				}
 时间	   	: 2020-08-23 17:16
@@ -29,8 +31,15 @@ Copyright © wkangk <wangkangchn@163.com>
 #ifndef __WKANGK_STACK_H__
 #define __WKANGK_STACK_H__
 #include <stdlib.h>
+#include <string.h>
+#include <assert.h>
 #include <pthread.h>
+#include "tools.h"
 
+/* 
+ * @max_length:	data 的容量
+ * @top:		栈顶下标, 空栈为 -1
+ *  */
 #define DEFINE_STACK_ELEMENT_TYPE(type, name)	\
 	typedef struct name					\
 	{									\
@@ -41,12 +50,38 @@ Copyright © wkangk <wangkangchn@163.com>
 	} name
 
 /* 成功返回1, 失败返回0 */
-#define sinit(S, max) ({									\
-        (S)->max_length = (int)(max);							\
+#define sinit(S, len) ({									\
+        (S)->max_length = max((unsigned int)(len), 1U);		\
 		(S)->top = -1;									\
-        (S)->data = calloc((max), sizeof(*( (S)->data) ));  \
+        (S)->data = calloc((S)->max_length, sizeof(*( (S)->data) ));  \
 		(S)->data && !pthread_mutex_init(&( (S)->mutex ), NULL);	})
 
+/**
+ * __sresize - 将栈的容量调整为 n, 失败产生断言错误
+ */
+#define __sresize(S, n) ({									\
+		(S)->max_length = (n);								\
+		(S)->data = realloc((S)->data, (S)->max_length * sizeof(*( (S)->data) ));	\
+		assert((S)->data);	})
+
+/* sreserve - 预留可容纳 n 个元素的空间, 容量足够时不做任何操作 */
+#define sreserve(S, n) ({									\
+		unsigned int __n = (n);								\
+		if (__n > (S)->max_length)							\
+			__sresize(S, __n);	})
+
+/* sshrink_to_fit - 释放栈顶以上的多余空间 */
+#define sshrink_to_fit(S) ({								\
+		unsigned int __n = max((unsigned int)ssize(S), 1U);	\
+		if (__n < (S)->max_length)							\
+			__sresize(S, __n);	})
+
+/* __sgrow - 栈满时容量翻倍, 保证入栈的均摊代价为 O(1) */
+#define __sgrow(S, n) ({									\
+		unsigned int __need = ssize(S) + (n);				\
+		if (__need > (S)->max_length)						\
+			sreserve(S, max(__need, (S)->max_length * 2));	})
+
 /* size - 获取栈长度*/
 #define ssize(S) 		({ (S)->top + 1; })
 
@@ -54,16 +89,29 @@ Copyright © wkangk <wangkangchn@163.com>
 #define sis_empty(S) 	({ (S)->top < 0; })
 
 /* is_full - 判断栈是否为满 */
-#define sis_full(S) 		({ (S)->top == (S)->max_length; })
+#define sis_full(S) 		({ (S)->top == (int)(S)->max_length - 1; })
 
 /* pop - 弹栈 */
 #define spop(S) 			({ (S)->data[(S)->top--]; })
 
-/* push - 入栈 */
+/* push - 入栈, 栈满时自动扩容 */
 #define spush(S, x) ({ 				\
 	const typeof( x ) __x = (x);	\
+	__sgrow(S, 1);					\
 	(S)->data[++( (S)->top )] = __x;	})
 
+/**
+ * spush_n - 将数组 src 中的 n 个元素依次入栈, src[n - 1] 位于栈顶
+ * @S:		栈
+ * @src:	待入栈的数组
+ * @n:		元素个数
+ */
+#define spush_n(S, src, n) ({ 			\
+	unsigned int __cnt = (n);			\
+	__sgrow(S, __cnt);					\
+	memcpy((S)->data + (S)->top + 1, (src), __cnt * sizeof(*( (S)->data) ));	\
+	(S)->top += __cnt;	})
+
 /* clear - 清空缓冲区 */
 #define sclear(S) 		({				\
 	pthread_mutex_destroy(&( (S)->mutex ));	\
@@ -73,14 +121,14 @@ Copyright © wkangk <wangkangchn@163.com>
 #define spop_mutex(S) 	({					\
 		typeof( *( (S)->data ) ) __x;				\
 		pthread_mutex_lock(&(S)->mutex);		\
-		__x = pop( (S) );						\
+		__x = spop( (S) );						\
 		pthread_mutex_unlock(&(S)->mutex);	\
 		__x;	})
 
 /* push_mutex - 入栈(带互斥锁) */
 #define spush_mutex(S, x) ({ 		\
 	pthread_mutex_lock(&( (S)->mutex ));	\
-	push( (S), x );						\
+	spush( (S), x );						\
 	pthread_mutex_unlock(&( (S)->mutex ));	})
 
 #endif // !__WKANGK_STACK_H__
\ No newline at end of file
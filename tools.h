@@ -35,6 +35,141 @@ Copyright © wkangk <wangkangchn@163.com>
 /* 释放缓冲区缓冲区 */
 #define free_buf(buf) ({ free( (buf) ); (buf) = NULL; })
 
+/* 缓存行大小, 被多个线程分别写入的成员按缓存行对齐, 避免伪共享 */
+#define CACHELINE_SIZE          64
+#define __cacheline_aligned     __attribute__((aligned(CACHELINE_SIZE)))
+
+/* roundup_pow_of_two - 向上取整到 2 的幂(n > 0) */
+#define roundup_pow_of_two(n)   ({ (n) <= 1 ? (unsigned long)1 : 1UL << (sizeof(long) * 8 - __builtin_clzl((unsigned long)(n) - 1)); })
+
+/* 
+            定长对象池
+    同一类型的对象从大块内存中切分, 释放的对象挂入空闲链表复用, 
+    pool_reset 一次性释放池中全部对象.
+e.g.
+obj_pool pool;
+pool_init(&pool, struct node, 256);
+struct node *p = pool_alloc(&pool, struct node);
+...
+pool_free(&pool, p);
+pool_reset(&pool);
+ */
+#include <string.h>
+typedef struct obj_pool {
+    size_t obj_size;        /* 对象大小(按 align 对齐) */
+    size_t align;           /* 对象对齐, max(_Alignof(type), sizeof(void *)) */
+    size_t per_block;       /* 每个内存块中的对象个数 */
+    void *free_list;        /* 空闲对象链表, 对象首部存放下一个空闲对象的地址 */
+    void *blocks;           /* 内存块链表, 块首部存放下一块的地址 */
+    char *cur, *end;        /* 当前块中尚未切分的区域 */
+} obj_pool;
+
+/**
+ * pool_init - 初始化对象池
+ * @P:          对象池
+ * @type:       池中对象类型
+ * @n:          每次向系统申请的对象个数
+ */
+#define pool_init(P, type, n) ({    \
+    (P)->align = max( _Alignof(type), sizeof(void *) );  \
+    (P)->obj_size = ( max(sizeof(type), sizeof(void *)) + (P)->align - 1 ) & ~((P)->align - 1);  \
+    (P)->per_block = max( (size_t)(n), (size_t)1 ); \
+    (P)->free_list = (P)->blocks = NULL;            \
+    (P)->cur = (P)->end = NULL; })
+
+/**
+ * __pool_grow - 向系统申请一个可容纳 n 个对象的内存块
+ *      Note:
+ *          块按 align 对齐, 块首部占 align 字节(不小于指针大小), 块内每个对象均按 align 对齐
+ * @pool:   对象池
+ * @n:      对象个数
+ * @return: 无
+ */
+static inline void __pool_grow(obj_pool *pool, size_t n)
+{
+    char *block = (char *)aligned_alloc(pool->align, pool->align + n * pool->obj_size);
+    assert(block);
+
+    *(void **)block = pool->blocks;
+    pool->blocks = block;
+    pool->cur = block + pool->align;
+    pool->end = pool->cur + n * pool->obj_size;
+}
+
+/**
+ * __pool_alloc - 从对象池中取出一个清零的对象
+ * @pool:   对象池
+ * @return: 对象地址
+ */
+static inline void *__pool_alloc(obj_pool *pool)
+{
+    void *obj = pool->free_list;
+
+    if (obj) {
+        pool->free_list = *(void **)obj;
+    } else {
+        if (pool->cur == pool->end)
+            __pool_grow(pool, pool->per_block);
+        obj = pool->cur;
+        pool->cur += pool->obj_size;
+    }
+    return memset(obj, 0, pool->obj_size);
+}
+
+/* pool_alloc - 分配对象, 与 calloc_buf(1, type) 相同返回清零的对象 */
+#define pool_alloc(P, type)     ({ (type *)__pool_alloc( (P) ); })
+
+/**
+ * __pool_alloc_n - 从对象池中取出 n 个地址连续的清零对象, 不使用空闲链表
+ *      Note:
+ *          当前块剩余空间不足时, 剩余对象挂入空闲链表, 再申请一个至少容纳 n 个对象的新块
+ * @pool:   对象池
+ * @n:      对象个数
+ * @return: 第一个对象的地址
+ */
+static inline void *__pool_alloc_n(obj_pool *pool, size_t n)
+{
+    void *obj;
+
+    if ((size_t)(pool->end - pool->cur) < n * pool->obj_size) {
+        for (; pool->cur != pool->end; pool->cur += pool->obj_size) {
+            *(void **)pool->cur = pool->free_list;
+            pool->free_list = pool->cur;
+        }
+        __pool_grow(pool, n > pool->per_block ? n : pool->per_block);
+    }
+    obj = pool->cur;
+    pool->cur += n * pool->obj_size;
+    return memset(obj, 0, n * pool->obj_size);
+}
+
+/* pool_alloc_n - 分配 n 个连续对象, 可作为 type 数组使用, 每个对象可单独 pool_free */
+#define pool_alloc_n(P, type, n)    ({  \
+    assert( (P)->obj_size == sizeof(type) );    \
+    (type *)__pool_alloc_n( (P), (n) ); })
+
+/* pool_free - 将对象归还对象池 */
+#define pool_free(P, obj)       ({  \
+    *(void **)(obj) = (P)->free_list;   \
+    (P)->free_list = (obj); })
+
+/**
+ * pool_reset - 一次性释放对象池中的全部对象, 释放后对象池仍可继续使用
+ * @pool:   对象池
+ * @return: 无
+ */
+static inline void pool_reset(obj_pool *pool)
+{
+    void *block;
+
+    while ((block = pool->blocks) != NULL) {
+        pool->blocks = *(void **)block;
+        free(block);
+    }
+    pool->free_list = NULL;
+    pool->cur = pool->end = NULL;
+}
+
 
 /* swap - 交换两变量元素(使用异或操作进行交换)
     x, y 需要为同一种指针类型 
@@ -0,0 +1,318 @@
+/***************************************************************
+Copyright © wkangk <wangkangchn@163.com>
+文件名		: wsdeque.h
+作者	  	: wkangk <wangkangchn@163.com>
+版本	   	: v1.0
+描述	   	: 工作窃取双端队列(Chase-Lev)与线程池
+			每个工作线程拥有一个 ws_deque, 只有所有者在底部 push/take(后进先出),
+			其他线程在顶部 steal(先进先出), 只有取最后一个元素时所有者才与窃取者竞争.
+			队列满时数组按 2 倍扩容, 旧数组可能仍被窃取者读取, 在 ws_deque_destroy 时才释放.
+			ws_run 启动线程池执行一次并行遍历: 任务函数处理一个元素时通过 ws_spawn 派生
+			子任务(如左右子树, 邻接顶点), 空闲线程随机选择其他线程窃取任务,
+			所有已派生的任务执行完毕后 ws_run 返回.
+			使用方法:
+				1. 定义任务函数 void fn(ws_worker *w, void *item)
+				2. 任务函数中使用 ws_spawn(w, item) 派生子任务,
+				w->id 为线程编号(0 ~ nthreads - 1), 可用于按线程累加结果, w->arg 为 ws_run 的 arg
+				3. ws_run(nthreads, fn, root, arg) 以 root 为第一个任务并行执行
+			e.g.
+				static long sum[NTHREADS];
+
+				void visit(ws_worker *w, void *item)
+				{
+					bstree_node *node = item;
+					sum[w->id] += node->data;
+					if (node->left)		ws_spawn(w, node->left);
+					if (node->right)	ws_spawn(w, node->right);
+				}
+
+				ws_run(NTHREADS, visit, tree.root, NULL);
+时间	   	: 2026-10-18 21:20
+***************************************************************/
+#ifndef __WKANGK_WSDEQUE_H__
+#define __WKANGK_WSDEQUE_H__
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <sched.h>
+#include <pthread.h>
+#include "tools.h"
+
+/*
+ * @mask:	容量 - 1, 容量为 2 的幂
+ * @prev:	扩容前的数组, 销毁队列时一并释放
+ */
+struct ws_array {
+	long mask;
+	struct ws_array *prev;
+	void *buf[];
+};
+
+/*
+ * @top:	窃取端, 由所有窃取者 CAS 修改
+ * @bottom:	所有者端, 只由所有者修改
+ */
+typedef struct ws_deque {
+	long top __cacheline_aligned;
+	long bottom __cacheline_aligned;
+	struct ws_array *array;
+} ws_deque;
+
+/* steal 的返回值, 与其他窃取者竞争失败, 可以重试 */
+#define WS_ABORT	((void *)-1L)
+
+static inline struct ws_array *__ws_array_new(long size, struct ws_array *prev)
+{
+	struct ws_array *a = malloc(sizeof(struct ws_array) + size * sizeof(void *));
+	assert(a);
+
+	a->mask = size - 1;
+	a->prev = prev;
+	return a;
+}
+
+static inline void *__ws_array_get(struct ws_array *a, long i)
+{
+	return __atomic_load_n(&a->buf[i & a->mask], __ATOMIC_RELAXED);
+}
+
+static inline void __ws_array_put(struct ws_array *a, long i, void *x)
+{
+	__atomic_store_n(&a->buf[i & a->mask], x, __ATOMIC_RELAXED);
+}
+
+/**
+ * ws_deque_init - 初始化队列
+ * @q:		队列
+ * @size:	初始容量, 向上取整为 2 的幂
+ * @return:	无
+ */
+static inline void ws_deque_init(ws_deque *q, long size)
+{
+	q->top = q->bottom = 0;
+	q->array = __ws_array_new(roundup_pow_of_two(max(size, 2L)), NULL);
+}
+
+/* ws_deque_destroy - 释放当前数组及扩容前的全部数组 */
+static inline void ws_deque_destroy(ws_deque *q)
+{
+	struct ws_array *a, *prev;
+
+	for (a = q->array; a; a = prev) {
+		prev = a->prev;
+		free(a);
+	}
+	q->array = NULL;
+}
+
+/* ws_deque_size - 队列长度(仅作参考, 读取期间可能被其他线程修改) */
+static inline long ws_deque_size(ws_deque *q)
+{
+	long b = __atomic_load_n(&q->bottom, __ATOMIC_RELAXED);
+	long t = __atomic_load_n(&q->top, __ATOMIC_RELAXED);
+	return b > t ? b - t : 0;
+}
+
+/* __ws_deque_grow - 容量翻倍, 只由所有者调用 */
+static inline struct ws_array *__ws_deque_grow(ws_deque *q, struct ws_array *a, long t, long b)
+{
+	struct ws_array *na = __ws_array_new((a->mask + 1) << 1, a);
+	long i;
+
+	for (i = t; i < b; ++i)
+		__ws_array_put(na, i, __ws_array_get(a, i));
+	__atomic_store_n(&q->array, na, __ATOMIC_RELEASE);
+	return na;
+}
+
+/**
+ * ws_deque_push - 所有者在底部入队
+ * @q:		队列
+ * @x:		元素, 不能为 NULL 或 WS_ABORT
+ * @return:	无
+ */
+static inline void ws_deque_push(ws_deque *q, void *x)
+{
+	long b = __atomic_load_n(&q->bottom, __ATOMIC_RELAXED);
+	long t = __atomic_load_n(&q->top, __ATOMIC_ACQUIRE);
+	struct ws_array *a = __atomic_load_n(&q->array, __ATOMIC_RELAXED);
+
+	if (b - t > a->mask)
+		a = __ws_deque_grow(q, a, t, b);
+	__ws_array_put(a, b, x);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	__atomic_store_n(&q->bottom, b + 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * ws_deque_take - 所有者从底部出队
+ * @q:		队列
+ * @return:	最后入队的元素, 队列空返回 NULL
+ */
+static inline void *ws_deque_take(ws_deque *q)
+{
+	long b = __atomic_load_n(&q->bottom, __ATOMIC_RELAXED) - 1;
+	struct ws_array *a = __atomic_load_n(&q->array, __ATOMIC_RELAXED);
+	long t;
+	void *x = NULL;
+
+	__atomic_store_n(&q->bottom, b, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	t = __atomic_load_n(&q->top, __ATOMIC_RELAXED);
+	if (t <= b) {
+		x = __ws_array_get(a, b);
+		if (t == b) {
+			/* 最后一个元素, 与窃取者竞争 */
+			if (!__atomic_compare_exchange_n(&q->top, &t, t + 1, false,
+											__ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+				x = NULL;
+			__atomic_store_n(&q->bottom, b + 1, __ATOMIC_RELAXED);
+		}
+	} else
+		__atomic_store_n(&q->bottom, b + 1, __ATOMIC_RELAXED);
+	return x;
+}
+
+/**
+ * ws_deque_steal - 其他线程从顶部窃取
+ * @q:		队列
+ * @return:	最早入队的元素, 队列空返回 NULL, 竞争失败返回 WS_ABORT
+ */
+static inline void *ws_deque_steal(ws_deque *q)
+{
+	long t = __atomic_load_n(&q->top, __ATOMIC_ACQUIRE);
+	long b;
+	struct ws_array *a;
+	void *x;
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	b = __atomic_load_n(&q->bottom, __ATOMIC_ACQUIRE);
+	if (t >= b)
+		return NULL;
+	a = __atomic_load_n(&q->array, __ATOMIC_ACQUIRE);
+	x = __ws_array_get(a, t);
+	if (!__atomic_compare_exchange_n(&q->top, &t, t + 1, false,
+									__ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+		return WS_ABORT;
+	return x;
+}
+
+/*
+            线程池
+ */
+typedef struct ws_pool ws_pool;
+typedef struct ws_worker ws_worker;
+typedef void (*ws_task_fn)(ws_worker *w, void *item);
+
+/*
+ * @id:		线程编号
+ * @arg:	ws_run 传入的参数
+ * @seed:	随机选择窃取对象
+ */
+struct ws_worker {
+	ws_deque deque;
+	ws_pool *pool;
+	unsigned int id;
+	unsigned int seed;
+	void *arg;
+} __cacheline_aligned;
+
+/*
+ * @pending:	已派生但尚未执行完毕的任务数, 为 0 时遍历结束
+ */
+struct ws_pool {
+	long pending __cacheline_aligned;
+	ws_task_fn fn;
+	unsigned int nthreads;
+	ws_worker *workers;
+};
+
+/* ws_spawn - 派生子任务, 只能在任务函数中调用 */
+static inline void ws_spawn(ws_worker *w, void *item)
+{
+	__atomic_add_fetch(&w->pool->pending, 1, __ATOMIC_RELAXED);
+	ws_deque_push(&w->deque, item);
+}
+
+/* __ws_steal - 随机选择一个其他线程窃取一个任务 */
+static inline void *__ws_steal(ws_worker *w)
+{
+	ws_pool *pool = w->pool;
+	unsigned int victim;
+	void *x;
+
+	if (pool->nthreads == 1)
+		return NULL;
+	/* xorshift */
+	w->seed ^= w->seed << 13;
+	w->seed ^= w->seed >> 17;
+	w->seed ^= w->seed << 5;
+	victim = w->seed % (pool->nthreads - 1);
+	victim += victim >= w->id;
+	do {
+		x = ws_deque_steal(&pool->workers[victim].deque);
+	} while (x == WS_ABORT);
+	return x;
+}
+
+static inline void *__ws_worker_loop(void *arg)
+{
+	ws_worker *w = arg;
+	ws_pool *pool = w->pool;
+	void *item;
+
+	while (__atomic_load_n(&pool->pending, __ATOMIC_ACQUIRE) > 0) {
+		if ((item = ws_deque_take(&w->deque)) == NULL
+				&& (item = __ws_steal(w)) == NULL) {
+			sched_yield();
+			continue;
+		}
+		pool->fn(w, item);
+		/* 子任务已在 fn 中计入 pending, 此时减 1 不会提前归零 */
+		__atomic_sub_fetch(&pool->pending, 1, __ATOMIC_RELEASE);
+	}
+	return NULL;
+}
+
+/**
+ * ws_run - 启动 nthreads 个线程(含调用线程)并行执行, 直到全部任务完成
+ * @nthreads:	线程数
+ * @fn:			任务函数
+ * @root:		第一个任务, 为 NULL 时直接返回
+ * @arg:		传给任务函数的参数, 通过 w->arg 访问
+ * @return:		无
+ */
+static inline void ws_run(unsigned int nthreads, ws_task_fn fn, void *root, void *arg)
+{
+	ws_pool pool = { .pending = 0, .fn = fn, .nthreads = max(nthreads, 1U) };
+	pthread_t *threads;
+	unsigned int i;
+
+	if (root == NULL)
+		return;
+	pool.workers = aligned_alloc(CACHELINE_SIZE, pool.nthreads * sizeof(ws_worker));
+	threads = calloc(pool.nthreads, sizeof(pthread_t));
+	assert(pool.workers && threads);
+	for (i = 0; i < pool.nthreads; ++i) {
+		ws_deque_init(&pool.workers[i].deque, 256);
+		pool.workers[i].pool = &pool;
+		pool.workers[i].id = i;
+		pool.workers[i].seed = 2463534242U + i;
+		pool.workers[i].arg = arg;
+	}
+
+	pool.pending = 1;
+	ws_deque_push(&pool.workers[0].deque, root);
+	for (i = 1; i < pool.nthreads; ++i)
+		pthread_create(threads + i, NULL, __ws_worker_loop, pool.workers + i);
+	__ws_worker_loop(pool.workers);
+	for (i = 1; i < pool.nthreads; ++i)
+		pthread_join(threads[i], NULL);
+
+	for (i = 0; i < pool.nthreads; ++i)
+		ws_deque_destroy(&pool.workers[i].deque);
+	free(threads);
+	free(pool.workers);
+}
+
+#endif // !__WKANGK_WSDEQUE_H__